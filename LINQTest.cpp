@@ -3,7 +3,6 @@
 #include <sstream>
 #include <vector>
 #include <string>
-#include <format>
 #include "STLHelpers.h"
 
 using namespace linq;
@@ -36,7 +35,7 @@ void assert_eq(const auto&& a, const auto&& b)
 			break;
 
 		if(it1_finished != it2_finished || *it1 != *it2)
-			throw std::runtime_error( std::format("LINQ tests: Expected containers to be equal {} == {}", print_container(a), print_container(b)) );
+			throw std::runtime_error( "LINQ tests: Expected containers to be equal " + print_container(a) + " == " + print_container(b) );
 
 		++it1, ++it2;
 	}
@@ -1,10 +1,29 @@
 #include "LockFreeFixedSizeHashmap.h"
+#include "LockFreeFixedSizeHashmapShm.h"
+#include "LockFreeOpenAddressingHashmap.h"
+#include "LockFreeGrowableHashmap.h"
+#include "LockFreeReplicatedHashmap.h"
+#include "LockFreeFixedSizeHashmapSnapshot.h"
+#include "LockFreeFixedSizeHashmapStress.h"
+#include "LockFreeVarLenHashmap.h"
 #include <vector>
 #include <set>
+#include <map>
 #include <random>
+#include <string>
 #include <thread>
 #include <algorithm>
 
+#if defined(_MSC_VER)
+#include <crtdbg.h>
+#endif
+
+#if __has_include(<sys/wait.h>)
+#include <unistd.h>
+#include <sys/wait.h>
+#define HAS_FORK 1
+#endif
+
 // 1. Set up the random number generator and distribution
 static std::mt19937 gen(std::random_device{}()); // Mersenne Twister engine
 static std::uniform_int_distribution<> dis(1, 1000); // Numbers between 1 and 1000
@@ -14,10 +33,10 @@ static std::uniform_int_distribution<> dis(1, 1000); // Numbers between 1 and 10
 std::vector<int> random_keys(int n = 100)
 {
 	std::set<int> random_numbers;
-	while (random_numbers.size() < n)
+	while (random_numbers.size() < size_t(n))
 		random_numbers.insert(dis(gen));
 
-	std::vector<int> ret(std::from_range, random_numbers);
+	std::vector<int> ret(random_numbers.begin(), random_numbers.end());
 	std::ranges::shuffle(ret, gen);
 	
 	return ret;
@@ -26,7 +45,7 @@ std::vector<int> random_keys(int n = 100)
 template<size_t ... Idx>
 auto spawn_n_of_h(auto lambda, std::index_sequence<Idx...> )
 {
-	return std::array<std::jthread, sizeof...(Idx)>{ (Idx, std::jthread{ lambda }) ... };
+	return std::array<std::jthread, sizeof...(Idx)>{ ((void)Idx, std::jthread{ lambda }) ... };
 }
 
 template<int N>
@@ -36,12 +55,20 @@ auto spawn_n_of(auto lambda)
 }
 
 
+//	stops under the debugger right at the failed check (MSVC debug builds), elsewhere the exception is enough
+void debug_break()
+{
+#if defined(_MSC_VER)
+	_CrtDbgBreak();
+#endif
+}
+
 void assert_true(bool res)
 {
 	if (!res)
 	{
-		_CrtDbgBreak();
-		throw std::runtime_error(std::format("lock_free_hash_map_tests: Expected true"));
+		debug_break();
+		throw std::runtime_error("lock_free_hash_map_tests: Expected true");
 	}
 }
 
@@ -49,8 +76,8 @@ void assert_false(bool res)
 {
 	if (res)
 	{
-		_CrtDbgBreak();
-		throw std::runtime_error(std::format("lock_free_hash_map_tests: Expected false"));
+		debug_break();
+		throw std::runtime_error("lock_free_hash_map_tests: Expected false");
 	}
 }
 
@@ -58,8 +85,8 @@ void assert_eq(int a, int b)
 {
 	if (a != b)
 	{
-		_CrtDbgBreak();
-		throw std::runtime_error(std::format("lock_free_hash_map_tests: Expected numbers to be equal {} == {}", a, b));
+		debug_break();
+		throw std::runtime_error("lock_free_hash_map_tests: Expected numbers to be equal " + std::to_string(a) + " == " + std::to_string(b));
 	}
 }
 
@@ -67,8 +94,11 @@ void assert_is_among(int a, std::initializer_list<int> b)
 {
 	if (std::ranges::find(b, a) == b.end())
 	{
-		_CrtDbgBreak();
-		throw std::runtime_error(std::format("lock_free_hash_map_tests: Expected numbers to be equal {} == {}", a, b));
+		debug_break();
+		std::string message = "lock_free_hash_map_tests: Expected " + std::to_string(a) + " to be among";
+		for (int val : b)
+			message += ' ' + std::to_string(val);
+		throw std::runtime_error(message);
 	}
 }
 
@@ -88,7 +118,7 @@ void test_allocator()
 					try { allocator.alloc(); }
 					catch (const std::exception&) { break; }
 
-					throw std::runtime_error(std::format("Overallocation expected to throw, {}", allocator.NodesMax));
+					throw std::runtime_error("Overallocation expected to throw, " + std::to_string(allocator.NodesMax));
 				}
 
 				for (size_t i = 0; i < allocator.NodesMax; ++i)
@@ -283,7 +313,7 @@ void test_other_key_writer_does_not_affect_reader2()
 			{
 				//	prevent duplicates, so remove always succeed
 				num = dis(gen);
-				if (!std::ranges::contains(inserted, num))
+				if (std::ranges::find(inserted, num) == inserted.end())
 					break;
 			}
 
@@ -429,7 +459,7 @@ void test_visit_vs_deletes()
 		for (int repeat = 0; repeat < 100; ++repeat)
 		{
 			int visited = 0;
-			hmap.visit([&](const std::pair<int, int>& keyval) {
+			hmap.visit([&](const std::pair<int, int>&) {
 				++visited;
 			});
 
@@ -442,12 +472,2080 @@ void test_visit_vs_deletes()
 			visited_history.push_back(visited);
 		}
 
-		assert_true(visited_history[0] <= c_elements_num);
+		assert_true(size_t(visited_history[0]) <= c_elements_num);
 		assert_eq(visited_history.back(), 0);
 		assert_true(std::is_sorted(visited_history.rbegin(), visited_history.rend()));
 	});
 }
 
+//	test - batched read must match per key read
+//		thr1 - writes and deletes noise keys
+//		thr2 - batch reads mix of stable keys and guaranteed missing ones
+void test_read_batch()
+{
+	constexpr size_t c_elements_num = 1000;
+	constexpr size_t c_num_of_reading_threads = 5;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	LockFreeFixedSizeHashMap <int, int, c_elements_num + 100> hmap;
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, i * i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		std::vector<int> inserted;
+		for (int repeat = 0; repeat < 10000; ++repeat)
+		{
+			if (inserted.size() == c_elements_num)
+			{
+				hmap.remove(inserted[0]);
+				inserted.erase(inserted.begin());
+			}
+
+			int num = dis(gen);	//	duplicates are fine
+			hmap.store(num, num);
+			inserted.push_back(num);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		std::vector<int> keys(37);	//	not multiple of the internal group size
+		std::vector<std::optional<int>> values(keys.size());
+		for (int repeat = 0; repeat < 2000; ++repeat)
+		{
+			for (size_t i = 0; i < keys.size(); ++i)
+				keys[i] = i % 2 == 0 ? -1 - dis(gen) % 100 : -dis(gen) - 1000;
+
+			hmap.read_batch(keys, values);
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				assert_eq(values[i].has_value(), i % 2 == 0);
+				if (values[i])
+					assert_eq(*values[i], keys[i] * keys[i]);
+			}
+		}
+	});
+}
+
+//	Wide value, every field is written with the same number, torn reads would show different ones
+struct WideValue
+{
+	int fields[64];
+	explicit WideValue(int num = 0) { std::fill(std::begin(fields), std::end(fields), num); }
+};
+
+//	test - zero copy reads, projections never see a torn value
+//		writer keeps rewriting wide values, readers check both ends of the value through read_with/visit_with
+void test_read_with()
+{
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	LockFreeFixedSizeHashMap<int, WideValue, 200> hmap;
+	for (int i = 0; i < 100; ++i)
+		hmap.store(i, WideValue(i));
+
+	assert_true(hmap.read_with(5, [](const WideValue& value) { return value.fields[10]; }) == 5);
+	assert_false(hmap.read_with(500, [](const WideValue& value) { return value.fields[10]; }).has_value());
+
+	int visited = 0;
+	hmap.visit_with([](int key, const WideValue& value) { return key - value.fields[63]; }, [&](int diff) {
+		assert_eq(diff, 0);
+		++visited;
+		});
+	assert_eq(visited, 100);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+			hmap.store(repeat % 100, WideValue(repeat));
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 5000; ++repeat)
+		{
+			auto ends = hmap.read_with(repeat % 100, [](const WideValue& value) { return std::make_pair(value.fields[0], value.fields[63]); });
+			assert_true(ends.has_value());
+			assert_eq(ends->first, ends->second);
+			assert_eq(ends->first % 100, repeat % 100);
+
+			hmap.visit_with([](int, const WideValue& value) { return std::make_pair(value.fields[0], value.fields[63]); },
+				[](std::pair<int, int> ends) { assert_eq(ends.first, ends.second); });
+		}
+	});
+}
+
+template<typename Layout>
+struct NodeLayoutTraits : hashmap_policy::DefaultTraits { using NodeLayout = Layout; };
+
+//	test - every node layout policy behaves the same
+//		single threaded pass over store/overwrite/remove/visit, then stable keys are read while writer churns noise around them
+template<typename Layout>
+void test_node_layout()
+{
+	using Traits = NodeLayoutTraits<Layout>;
+	constexpr size_t c_elements_num = 300;
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	LockFreeFixedSizeHashMap <int, int, c_elements_num + 100, Traits> hmap;
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, 0);
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, i * i);
+	for (int i = -100; i <= -1; i += 2)
+		assert_true(hmap.remove(i));
+	for (int i = -100; i <= -1; ++i)
+		assert_eq(hmap.read(i).has_value(), i % 2 != 0);
+
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>& keyval) {
+		assert_eq(keyval.second, keyval.first * keyval.first);
+		++visited;
+		});
+	assert_eq(visited, 50);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		std::vector<int> inserted;
+		for (int repeat = 0; repeat < 5000; ++repeat)
+		{
+			if (inserted.size() == c_elements_num)
+			{
+				hmap.remove(inserted[0]);
+				inserted.erase(inserted.begin());
+			}
+
+			int num = dis(gen);	//	duplicates are fine
+			hmap.store(num, num);
+			inserted.push_back(num);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 10000; ++repeat)
+		{
+			int key = -1 - 2 * (repeat % 50);
+			std::optional<int> value = hmap.read(key);
+			assert_true(value.has_value());
+			assert_eq(*value, key * key);
+		}
+	});
+}
+
+struct MultiWriterTraits : hashmap_policy::DefaultTraits { using Writers = hashmap_policy::MultiWriter; };
+
+//	test - concurrent allocator never hands out the same index twice
+//		thr1..N - allocate a handful, check nobody else owns those, give them back
+void test_concurrent_allocator()
+{
+	constexpr size_t c_nodes_num = 1111;
+	constexpr size_t c_num_of_threads = 4;
+	std::atomic<int> start_counter = c_num_of_threads;
+
+	details::ConcurrentFixedAllocator<c_nodes_num> allocator;
+	std::array<std::atomic<int>, c_nodes_num> owners = {};
+
+	{
+		auto threads = spawn_n_of<c_num_of_threads>([&] mutable {
+			SYNC_START_THREADS();
+			std::vector<size_t> allocated;
+			for (int repeat = 0; repeat < 200; ++repeat)
+			{
+				for (int i = 0; i < 200; ++i)
+				{
+					size_t idx = allocator.alloc();
+					assert_eq(owners[idx].fetch_add(1), 0);
+					allocated.push_back(idx);
+				}
+
+				for (size_t idx : allocated)
+				{
+					owners[idx].fetch_sub(1);
+					allocator.free(idx);
+				}
+				allocated.clear();
+			}
+		});
+	}
+
+	//	everything is free again
+	for (size_t i = 0; i < c_nodes_num; ++i)
+		allocator.alloc();
+
+	bool overflow = false;
+	try { allocator.alloc(); }
+	catch (const std::exception&) { overflow = true; }
+	assert_true(overflow);
+}
+
+//	test - concurrent allocator on a nearly full bitmask, summary level must not lose free nodes
+//		fill up, free scattered nodes, exactly those must be allocatable again
+void test_concurrent_allocator_nearly_full()
+{
+	constexpr size_t c_nodes_num = 5000;	//	more than one summary word
+	auto allocator = std::make_unique<details::ConcurrentFixedAllocator<c_nodes_num>>();
+
+	for (int repeat = 0; repeat < 3; ++repeat)
+	{
+		std::vector<size_t> allocated;
+		for (size_t i = 0; i < c_nodes_num; ++i)
+			allocated.push_back(allocator->alloc());
+
+		std::ranges::sort(allocated);
+		assert_true(std::ranges::adjacent_find(allocated) == allocated.end());
+
+		size_t freed = 0;
+		for (size_t idx = repeat; idx < c_nodes_num; idx += 7 + repeat * 300)
+		{
+			allocator->free(idx);
+			++freed;
+		}
+
+		for (size_t i = 0; i < freed; ++i)
+			allocator->alloc();
+
+		bool overflow = false;
+		try { allocator->alloc(); }
+		catch (const std::exception&) { overflow = true; }
+		assert_true(overflow);
+
+		for (size_t idx = 0; idx < c_nodes_num; ++idx)
+			allocator->free(idx);
+	}
+}
+
+//	test - multiple writers, each owning its own keys
+//		thr1..N - write, overwrite and remove own keys, checking them back
+//		thr2 - reads keys none of the writers touches
+//		in the end map must hold exactly what writers left
+void test_multi_writer_disjoint_keys()
+{
+	constexpr int c_num_of_writing_threads = 4;
+	constexpr int c_keys_per_writer = 200;
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_writing_threads + c_num_of_reading_threads;
+	std::atomic<int> writer_id = 0;
+
+	LockFreeFixedSizeHashMap <int, int, c_num_of_writing_threads * c_keys_per_writer + 100, MultiWriterTraits> hmap;
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, i * i);
+
+	{
+		auto writer_threads = spawn_n_of<c_num_of_writing_threads>([&] mutable {
+			const int first_key = writer_id++ * c_keys_per_writer;
+			SYNC_START_THREADS();
+			for (int repeat = 1; repeat <= 20; ++repeat)
+			{
+				for (int key = first_key; key < first_key + c_keys_per_writer; ++key)
+					hmap.store(key, repeat);
+
+				for (int key = first_key + 1; key < first_key + c_keys_per_writer; key += 2)
+					assert_true(hmap.remove(key));
+
+				for (int key = first_key; key < first_key + c_keys_per_writer; ++key)
+				{
+					std::optional<int> value = hmap.read(key);
+					assert_eq(value.has_value(), key % 2 == 0);
+					if (value)
+						assert_eq(*value, repeat);
+				}
+			}
+		});
+
+		auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+			SYNC_START_THREADS();
+			for (int repeat = 0; repeat < 20000; ++repeat)
+			{
+				int key = -1 - repeat % 100;
+				std::optional<int> value = hmap.read(key);
+				assert_true(value.has_value());
+				assert_eq(*value, key * key);
+			}
+		});
+	}
+
+	std::set<int> visited;
+	hmap.visit([&](const std::pair<int, int>& keyval) {
+		assert_true(visited.insert(keyval.first).second);
+		if (keyval.first >= 0)
+			assert_eq(keyval.second, 20);
+		});
+	assert_eq(int(visited.size()), 100 + c_num_of_writing_threads * c_keys_per_writer / 2);
+}
+
+//	test - multiple writers fighting over the same few keys in a tiny map (long chains, constant relinking)
+//		thr1..N - randomly store or remove keys from the shared set
+//		thr2 - any read value must be consistent
+//		in the end no key is duplicated and no node is leaked
+void test_multi_writer_same_keys()
+{
+	constexpr int c_keys_num = 16;
+	constexpr size_t c_elements_num = 64;
+	constexpr int c_num_of_writing_threads = 4;
+	constexpr size_t c_num_of_reading_threads = 2;
+	std::atomic<int> start_counter = c_num_of_writing_threads + c_num_of_reading_threads;
+
+	LockFreeFixedSizeHashMap <int, int, c_elements_num, MultiWriterTraits> hmap;
+
+	{
+		auto writer_threads = spawn_n_of<c_num_of_writing_threads>([&] mutable {
+			SYNC_START_THREADS();
+			std::mt19937 writer_gen(std::random_device{}());
+			for (int repeat = 0; repeat < 5000; ++repeat)
+			{
+				int key = writer_gen() % c_keys_num;
+				if (writer_gen() % 2 == 0)
+					hmap.store(key, key * 10);
+				else
+					hmap.remove(key);
+			}
+		});
+
+		auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+			SYNC_START_THREADS();
+			for (int repeat = 0; repeat < 20000; ++repeat)
+			{
+				int key = repeat % c_keys_num;
+				std::optional<int> value = hmap.read(key);
+				if (value)
+					assert_eq(*value, key * 10);
+			}
+		});
+	}
+
+	std::set<int> visited;
+	hmap.visit([&](const std::pair<int, int>& keyval) {
+		assert_true(visited.insert(keyval.first).second);
+		assert_eq(keyval.second, keyval.first * 10);
+		});
+
+	for (int key = 0; key < c_keys_num; ++key)
+	{
+		assert_eq(hmap.read(key).has_value(), visited.contains(key));
+		assert_eq(hmap.remove(key), visited.contains(key));
+	}
+
+	//	all nodes have to be available again
+	for (int key = 0; key < int(c_elements_num); ++key)
+		hmap.store(key, key * 10);
+}
+
+struct MixHashTraits : hashmap_policy::DefaultTraits { template<typename K> using Hash = hashmap_policy::IntegerMixHash; };	//	same layout, other buckets
+
+//	test - layout validation of the shared memory region
+//		attaching to the region created for another map type must throw, attaching to the right one gives the same map
+void test_shared_memory_attach()
+{
+	using Map = LockFreeFixedSizeHashMap<int, int, 100>;
+	std::vector<std::byte> region(Map::shared_memory_size() + 64);
+	void* memory = region.data() + (64 - reinterpret_cast<uintptr_t>(region.data()) % 64) % 64;
+
+	auto expect_throw = [](auto attach) {
+		try { attach(); }
+		catch (const std::runtime_error&) { return; }
+		assert_true(false);
+	};
+
+	expect_throw([&] { Map::attach_to(memory, Map::shared_memory_size()); });	//	nothing constructed yet
+
+	Map* writer = Map::create_in(memory, Map::shared_memory_size());
+	writer->store(5, 25);
+
+	Map* reader = Map::attach_to(memory, Map::shared_memory_size());
+	assert_true(reader == writer);
+	assert_eq(*reader->read(5), 25);
+
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, long long, 100>::attach_to(memory, Map::shared_memory_size()); });
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, int, 101>::attach_to(memory, Map::shared_memory_size()); });
+	expect_throw([&] { Map::attach_to(memory, Map::shared_memory_size() - 1); });
+
+	struct SplitTraits : hashmap_policy::DefaultTraits { using NodeLayout = hashmap_policy::SplitNodes; };
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, int, 100, SplitTraits>::attach_to(memory, Map::shared_memory_size()); });
+	struct FastRangeTraits : hashmap_policy::DefaultTraits { using Buckets = hashmap_policy::PrimeFastRange; };	//	same bucket count, different placement
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, int, 100, FastRangeTraits>::attach_to(memory, Map::shared_memory_size()); });
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, int, 100, MixHashTraits>::attach_to(memory, Map::shared_memory_size()); });
+	struct ExactEqualTraits : hashmap_policy::DefaultTraits { using KeyEqual = std::equal_to<int>; };
+	expect_throw([&] { LockFreeFixedSizeHashMap<int, int, 100, ExactEqualTraits>::attach_to(memory, Map::shared_memory_size()); });
+}
+
+#ifdef HAS_FORK
+//	test - multiprocess, map in named shared memory segment
+//		parent - creates the segment and keeps writing and removing noise keys
+//		children - forked reader processes attach by name and must always read the prefilled keys
+void test_shared_memory_processes()
+{
+	using Map = LockFreeFixedSizeHashMap<int, int, 1000>;
+	constexpr int c_num_of_reading_processes = 4;
+	const std::string name = "/lfhm_test_" + std::to_string(getpid());
+
+	auto segment = SharedMemoryHashMap<Map>::create(name);
+	struct Unlink { const std::string& name; ~Unlink() { SharedMemoryHashMap<Map>::unlink(name); } } unlink_at_exit{ name };
+
+	//	prefill, keys from -100 to -1 stay intact
+	for (int i = -100; i <= -1; ++i)
+		segment->store(i, i * i);
+
+	std::vector<pid_t> readers;
+	for (int i = 0; i < c_num_of_reading_processes; ++i)
+	{
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			int exit_code = 0;
+			try
+			{
+				auto view = SharedMemoryHashMap<Map>::open(name);
+				for (int repeat = 0; repeat < 20000; ++repeat)
+				{
+					int key = -1 - repeat % 100;
+					std::optional<int> value = view->read(key);
+					if (!value || *value != key * key)
+						exit_code = 1;
+				}
+			}
+			catch (const std::exception&)
+			{
+				exit_code = 2;
+			}
+
+			//	skip parent's atexit handlers and destructors
+			_exit(exit_code);
+		}
+
+		assert_true(pid > 0);
+		readers.push_back(pid);
+	}
+
+	std::vector<int> inserted;
+	for (int repeat = 0; repeat < 10000; ++repeat)
+	{
+		if (inserted.size() == 500)
+		{
+			segment->remove(inserted.front());
+			inserted.erase(inserted.begin());
+		}
+
+		int num = dis(gen);	//	duplicates are fine
+		segment->store(num, num);
+		inserted.push_back(num);
+	}
+
+	for (pid_t pid : readers)
+	{
+		int status = 0;
+		assert_eq(int(waitpid(pid, &status, 0)), int(pid));
+		assert_true(WIFEXITED(status));
+		assert_eq(WEXITSTATUS(status), 0);
+	}
+}
+#endif
+
+//	test - open addressing map, single threaded sanity: overwrite, remove, overflow, keys probing through full groups
+void test_open_addressing_basics()
+{
+	constexpr size_t c_elements_num = 200;
+	LockFreeOpenAddressingHashMap<int, int, c_elements_num> hmap;
+	auto keys = random_keys(c_elements_num);
+
+	for (int key : keys)
+		hmap.store(key, key);
+	for (int key : keys)
+		hmap.store(key, key * key);
+
+	bool overflow = false;
+	try { hmap.store(-1, 0); }
+	catch (const std::exception&) { overflow = true; }
+	assert_true(overflow);
+
+	for (int key : keys)
+		assert_eq(*hmap.read(key), key * key);
+	assert_false(hmap.read(-1).has_value());
+
+	//	remove half, the other half must stay reachable even if it overflowed past removed keys
+	for (size_t i = 0; i < keys.size() / 2; ++i)
+		assert_true(hmap.remove(keys[i]));
+	assert_false(hmap.remove(keys[0]));
+
+	for (size_t i = 0; i < keys.size(); ++i)
+		assert_eq(hmap.read(keys[i]).has_value(), i >= keys.size() / 2);
+
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>& keyval) {
+		assert_eq(keyval.second, keyval.first * keyval.first);
+		++visited;
+		});
+	assert_eq(visited, int(keys.size() - keys.size() / 2));
+
+	//	churn, freed slots are reused without degrading
+	for (int repeat = 0; repeat < 10000; ++repeat)
+	{
+		int key = keys[repeat % (keys.size() / 2)];
+		hmap.store(key, repeat);
+		assert_eq(*hmap.read(key), repeat);
+		assert_true(hmap.remove(key));
+	}
+}
+
+//	test - open addressing map, writer churns keys around while readers must always find the stable ones
+//		thr1 - writes and deletes lots of random stuff
+//		thr2 - reads keys that are never touched
+void test_open_addressing_other_key_writer_does_not_affect_reader()
+{
+	constexpr size_t c_elements_num = 1000;
+	constexpr size_t c_num_of_reading_threads = 5;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	LockFreeOpenAddressingHashMap<int, int, c_elements_num + 100> hmap;
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, i * i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		std::vector<int> inserted;
+		for (int repeat = 0; repeat < 10000; ++repeat)
+		{
+			if (inserted.size() == c_elements_num)
+			{
+				int idx_to_remove = dis(gen) % c_elements_num;
+				hmap.remove(inserted[idx_to_remove]);
+				inserted.erase(inserted.begin() + idx_to_remove);
+			}
+
+			int num = dis(gen);	//	duplicates are fine
+			hmap.store(num, num);
+			inserted.push_back(num);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int key = -1 - repeat % 100;
+			std::optional<int> value = hmap.read(key);
+			assert_true(value.has_value());
+			assert_eq(*value, key * key);
+
+			assert_false(hmap.read(-dis(gen) - 1000).has_value());
+		}
+	});
+}
+
+
+//	Fixed size string key, looked up by std::string_view
+struct Name
+{
+	char text[16] = {};
+	Name() = default;
+	explicit Name(std::string_view str) { std::copy_n(str.data(), std::min(str.size(), sizeof(text) - 1), text); }
+	std::string_view view() const { return text; }
+};
+struct NameHash
+{
+	using is_transparent = void;
+	size_t operator()(const Name& name) const { return std::hash<std::string_view>()(name.view()); }
+	size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+};
+struct NameEqual
+{
+	bool operator()(const Name& lhs, const Name& rhs) const { return lhs.view() == rhs.view(); }
+	bool operator()(const Name& lhs, std::string_view rhs) const { return lhs.view() == rhs; }
+};
+struct NameTraits : hashmap_policy::DefaultTraits
+{
+	template<typename>
+	using Hash = NameHash;
+	using KeyEqual = NameEqual;
+};
+
+//	test - lookup by a key of other type than K, both maps
+//		long long keys are found by int keys, transparent hasher/equal finds names by string_view without building a Name
+void test_heterogeneous_lookup()
+{
+	//	std::hash<int> and std::hash<long long> need not agree - lookup key is hashed as K
+	LockFreeFixedSizeHashMap<long long, int, 100> hmap;
+	for (long long i = -50; i < 50; ++i)
+		hmap.store(i * 1000003, int(i));
+	for (int i = -50; i < 50; ++i)
+		assert_true(hmap.read(i * 1000003) == i);
+	assert_true(hmap.remove(7 * 1000003));
+	assert_false(hmap.read(7 * 1000003).has_value());
+
+	//	transparent hasher is called with the lookup key as is, no conversion to K
+	LockFreeFixedSizeHashMap<Name, int, 10, NameTraits> names;
+	names.store(Name("EURUSD"), 1);
+	names.store(Name("USDJPY"), 2);
+	assert_true(names.read(std::string_view("EURUSD")) == 1);
+	assert_true(names.read(std::string_view("USDJPY")) == 2);
+	assert_false(names.read(std::string_view("GBPUSD")).has_value());
+	assert_true(names.remove(std::string_view("EURUSD")));
+	assert_false(names.read(Name("EURUSD")).has_value());
+
+	//	same for the open addressing map
+	LockFreeOpenAddressingHashMap<long long, int, 100> open_addressing;
+	for (long long i = -50; i < 50; ++i)
+		open_addressing.store(i * 1000003, int(i));
+	for (int i = -50; i < 50; ++i)
+		assert_true(open_addressing.read(i * 1000003) == i);
+	assert_true(open_addressing.remove(7 * 1000003));
+	assert_false(open_addressing.read(7 * 1000003).has_value());
+
+	LockFreeOpenAddressingHashMap<Name, int, 10, NameTraits> open_names;
+	open_names.store(Name("EURUSD"), 1);
+	assert_true(open_names.read(std::string_view("EURUSD")) == 1);
+	assert_false(open_names.read(std::string_view("GBPUSD")).has_value());
+}
+
+template<typename Hasher>
+struct HasherTraits : hashmap_policy::DefaultTraits
+{
+	template<typename>
+	using Hash = Hasher;
+};
+
+//	test - hasher policy, strided keys still spread and found
+//		thr1 - stores and removes the even strided keys
+//		thr2 - reads the odd strided keys, always there with their value
+template<typename Hasher>
+void test_hasher()
+{
+	//	keys sharing a stride, the case identity std::hash is weak at
+	LockFreeFixedSizeHashMap<uint64_t, uint64_t, 1000, HasherTraits<Hasher>> hmap;
+	for (uint64_t i = 0; i < 1000; ++i)
+		hmap.store(i << 20, uint64_t(i));
+	for (uint64_t i = 0; i < 1000; i += 2)
+		assert_true(hmap.remove(i << 20));
+	for (uint64_t i = 0; i < 1000; ++i)
+		assert_eq(hmap.read(i << 20).has_value(), i % 2 != 0);
+	assert_false(hmap.read(uint64_t(1)).has_value());
+
+	std::atomic<int> start_counter = 2;
+	std::jthread writer{ [&] mutable {
+		SYNC_START_THREADS();
+		for (uint64_t repeat = 0; repeat < 5000; ++repeat)
+		{
+			hmap.store((repeat % 500) * 2 << 20, repeat);
+			hmap.remove((repeat % 500) * 2 << 20);
+		}
+	} };
+
+	SYNC_START_THREADS();
+	for (int repeat = 0; repeat < 10000; ++repeat)
+	{
+		uint64_t i = uint64_t(repeat % 500) * 2 + 1;
+		assert_true(hmap.read(i << 20) == i);
+	}
+}
+
+template<typename BucketsPolicy>
+struct BucketsTraits : hashmap_policy::DefaultTraits { using Buckets = BucketsPolicy; };
+
+//	test - buckets policy, sequential, negative and strided keys all spread and found
+//		thr1 - stores and removes strided keys
+//		thr2 - reads the sequential keys, always there with their value
+template<typename BucketsPolicy>
+void test_buckets()
+{
+	using Traits = BucketsTraits<BucketsPolicy>;
+	constexpr int64_t c_elements_num = 1000;
+
+	//	small sequential, negative and strided keys - all of them have to be spread and found
+	LockFreeFixedSizeHashMap<int64_t, int64_t, c_elements_num * 3, Traits> hmap;
+	for (int64_t i = 0; i < c_elements_num; ++i)
+	{
+		hmap.store(i, i);
+		hmap.store(-i - 1, i);
+		hmap.store((i + 1) << 32, i);
+	}
+	for (int64_t i = 0; i < c_elements_num; i += 2)
+		assert_true(hmap.remove((i + 1) << 32));
+	for (int64_t i = 0; i < c_elements_num; ++i)
+	{
+		assert_true(hmap.read(i) == i);
+		assert_true(hmap.read(-i - 1) == i);
+		assert_eq(hmap.read((i + 1) << 32).has_value(), i % 2 != 0);
+	}
+
+	std::atomic<int> start_counter = 2;
+	std::jthread writer{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int64_t repeat = 0; repeat < 5000; ++repeat)
+		{
+			hmap.store((repeat % 500 * 2 + 1) << 32, repeat);
+			hmap.remove((repeat % 500 * 2 + 1) << 32);
+		}
+	} };
+
+	SYNC_START_THREADS();
+	for (int repeat = 0; repeat < 10000; ++repeat)
+		assert_true(hmap.read(int64_t(repeat % c_elements_num)) == repeat % c_elements_num);
+}
+
+template<typename BackoffPolicy>
+struct BackoffTraits : hashmap_policy::DefaultTraits
+{
+	using Backoff = BackoffPolicy;
+	using Stats = hashmap_policy::CountingStats;
+};
+
+//	test - backoff policy, readers retrying on nodes being changed never see a torn value
+//		thr1 - keeps overwriting the same few keys and churning their neighbours
+//		thr2..N - read_with both ends of the value, they must match
+template<typename BackoffPolicy>
+void test_backoff()
+{
+	using Traits = BackoffTraits<BackoffPolicy>;
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	//	few keys, constantly overwritten - readers keep running into nodes being changed
+	LockFreeFixedSizeHashMap<int, WideValue, 20, Traits> hmap;
+	for (int i = 0; i < 10; ++i)
+		hmap.store(i, WideValue(i));
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			hmap.store(repeat % 10, WideValue(repeat));
+			hmap.store(10 + repeat % 10, WideValue(repeat));
+			hmap.remove(10 + repeat % 10);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			auto ends = hmap.read_with(repeat % 10, [](const WideValue& value) { return std::make_pair(value.fields[0], value.fields[63]); });
+			assert_true(ends.has_value());
+			assert_eq(ends->first, ends->second);
+		}
+	});
+}
+
+//	test - stats policy, chain length and overflows are counted, nothing is counted without it
+void test_stats()
+{
+	struct Traits : hashmap_policy::DefaultTraits { using Stats = hashmap_policy::CountingStats; };
+
+	LockFreeFixedSizeHashMap<int, int, 10, Traits> hmap;
+	HashMapStats stats = hmap.stats();
+	assert_eq(int(stats.retries + stats.restarts + stats.max_chain_length + stats.overflows), 0);
+
+	for (int i = 0; i < 10; ++i)
+		hmap.store(i, i);
+	assert_true(hmap.stats().max_chain_length >= 1);
+
+	try { hmap.store(10, 10); }
+	catch (const std::runtime_error&) {}
+	assert_eq(int(hmap.stats().overflows), 1);
+	assert_eq(int(hmap.stats().retries), 0);
+
+	//	no stats - nothing counted, nothing stored
+	LockFreeFixedSizeHashMap<int, int, 10> plain;
+	try { for (int i = 0; i < 11; ++i) plain.store(i, i); }
+	catch (const std::runtime_error&) {}
+	assert_eq(int(plain.stats().overflows), 0);
+}
+
+//	test - epoch reclamation, removed node is not reused while a reader pinned before the removal may still be on it
+//		thr1 - writes and deletes lots of random stuff, recycling nodes
+//		thr2..N - read the prefilled keys, never derail onto a reused node (no restarts)
+//		then readers above the slot count, pinned through the overflow counter, still hold back reclamation
+void test_epoch_reclamation()
+{
+	struct Traits : hashmap_policy::DefaultTraits
+	{
+		using Reclamation = hashmap_policy::EpochReclamation<>;
+		using Stats = hashmap_policy::CountingStats;
+	};
+	constexpr size_t c_elements_num = 1000;
+	constexpr size_t c_num_of_reading_threads = 5;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+
+	//	removed nodes wait for reclamation, but full map still takes new keys
+	LockFreeFixedSizeHashMap<int, int, 100, Traits> small;
+	for (int i = 0; i < 10000; ++i)
+	{
+		small.store(i, i);
+		if (i >= 50)
+			assert_true(small.remove(i - 50));
+	}
+	int visited = 0;
+	small.visit([&](const std::pair<int, int>& keyval) { assert_true(keyval.first >= 10000 - 50); ++visited; });
+	assert_eq(visited, 50);
+	assert_eq(int(small.stats().overflows), 0);
+
+	LockFreeFixedSizeHashMap<int, int, c_elements_num + 100, Traits> hmap;
+	for (int i = -100; i <= -1; ++i)
+		hmap.store(i, i * i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		std::vector<int> inserted;
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			if (inserted.size() == c_elements_num)
+			{
+				int idx_to_remove = rand() % c_elements_num;
+				hmap.remove(inserted[idx_to_remove]);
+				inserted.erase(inserted.begin() + idx_to_remove);
+			}
+
+			int num = dis(gen);	//	duplicates are fine
+			hmap.store(num, num);
+			inserted.push_back(num);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int key = -1 - repeat % 100;
+			assert_true(hmap.read(key) == key * key);
+			hmap.read(dis(gen));
+		}
+	});
+
+	thr1.join();
+	for (auto& reader : reader_threads)
+		reader.join();
+	//	removed nodes are never reused under readers - nobody derails
+	assert_eq(int(hmap.stats().restarts), 0);
+
+	//	readers beyond the slots are counted in the overflow counter, nodes removed meanwhile wait for all of them
+	using Domain = hashmap_policy::EpochReclamation<2, 1>::Domain<16>;
+	Domain domain;
+	std::vector<size_t> freed;
+	auto free = [&](size_t node_idx) { freed.push_back(node_idx); };
+
+	//	0 - starting, 1 - both slots taken, 2 - let them go
+	std::atomic<int> stage = 0;
+	std::jthread slots_holder{ [&] {
+		auto first = domain.pin();
+		auto second = domain.pin();
+		stage = 1;
+		stage.notify_all();
+		stage.wait(1);
+	} };
+	stage.wait(0);
+	{
+		auto overflowing = domain.pin();
+		stage = 2;
+		stage.notify_all();
+		slots_holder.join();
+
+		domain.retire(1, free);
+		assert_true(freed.empty());
+	}
+	domain.retire(2, free);
+	assert_true(freed == std::vector<size_t>({ 1, 2 }));
+}
+
+//	test - capacity given at construction behaves like the compile time one
+//		fills up to capacity, overflow throws, then 3 writer threads store disjoint ranges into a multi writer map
+void test_dynamic_extent()
+{
+	struct Traits : hashmap_policy::DefaultTraits { using Buckets = hashmap_policy::PowerOfTwo; };
+
+	LockFreeFixedSizeHashMap<int, int, std::dynamic_extent, Traits> hmap(100);
+	assert_eq(int(hmap.capacity()), 100);
+	for (int i = 0; i < 100; ++i)
+		assert_true(hmap.store(i, i * i));
+	assert_false(hmap.store(5, 5));
+	for (int i = 0; i < 100; ++i)
+		assert_true(hmap.read(i) == (i == 5 ? 5 : i * i));
+
+	bool thrown = false;
+	try { hmap.store(100, 0); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+
+	LockFreeFixedSizeHashMap<int, int, std::dynamic_extent, MultiWriterTraits> concurrent(1000);
+	auto writer_threads = spawn_n_of<3>([&, writer = std::make_shared<std::atomic<int>>(0)] mutable {
+		const int first_key = writer->fetch_add(1) * 300;
+		for (int i = first_key; i < first_key + 300; ++i)
+			concurrent.store(i, i);
+	});
+	for (auto& writer : writer_threads)
+		writer.join();
+	for (int i = 0; i < 900; ++i)
+		assert_true(concurrent.read(i) == i);
+}
+
+//	test - growable map matches std::map through random stores and removes, growing on the way
+//		thr1 - stores lots of new keys, the map grows many times, removes some of them
+//		thr2..N - read the prefilled keys, always there with their value
+void test_growable()
+{
+	LockFreeGrowableHashMap<int, int> hmap(16);
+	std::map<int, int> expected;
+	for (int repeat = 0; repeat < 20000; ++repeat)
+	{
+		int key = dis(gen) * 10 + repeat % 10;
+		if (repeat % 3 == 2)
+			assert_eq(hmap.remove(key), expected.erase(key) == 1);
+		else
+		{
+			assert_eq(hmap.store(key, repeat), !expected.contains(key));
+			expected[key] = repeat;
+		}
+	}
+	assert_eq(int(hmap.size()), int(expected.size()));
+	assert_true(hmap.capacity() > 16);
+	for (int key = 0; key < 10010; ++key)
+	{
+		auto it = expected.find(key);
+		assert_true(hmap.read(key) == (it == expected.end() ? std::nullopt : std::optional<int>(it->second)));
+	}
+
+	//	readers keep finding keys which are always there, while the map grows under them many times
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeGrowableHashMap<int, int> growing(16);
+	for (int i = -100; i <= -1; ++i)
+		growing.store(i, i * i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = 0; i < 50000; ++i)
+		{
+			growing.store(i, i);
+			if (i % 4 == 0)
+				growing.remove(i / 2);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int key = -1 - repeat % 100;
+			assert_true(growing.read(key) == key * key);
+		}
+	});
+}
+
+struct SchedulePointTraits : hashmap_policy::DefaultTraits { using Schedule = hashmap_policy::SchedulePointHook; };
+
+//	writer: stores new keys until the map has grown once more and the migration is over
+template<typename Map>
+void grow_fully(Map& hmap, int& next_key)
+{
+	const size_t capacity = hmap.capacity();
+	while (hmap.capacity() == capacity || hmap.migrating())
+		hmap.store(next_key, next_key), ++next_key;
+}
+
+//	test - reader stalls between picking its readers group and joining it, while the map grows twice:
+//	the table it finds current after the first growth must not be freed by the second one under it
+void test_growable_parked_reader()
+{
+	using Point = hashmap_policy::SchedulePoint;
+	LockFreeGrowableHashMap<int, int, SchedulePointTraits> hmap(16);
+	for (int key = 0; key < 8; ++key)
+		hmap.store(key, key * 10);
+	int next_key = 100;
+
+	//	0 - reading, 1 - parked before joining its group, 2 - going on, 3 - parked inside of the table, 4 - going on
+	std::atomic<int> stage = 0;
+	auto park = [](void* context, Point point) {
+		std::atomic<int>& stage = *static_cast<std::atomic<int>*>(context);
+		const int current = stage.load();
+		if ((point == Point::ReaderEnter && current == 0) || (point == Point::BucketLoad && current == 2))
+		{
+			stage.store(current + 1);
+			stage.notify_all();
+			stage.wait(current + 1);
+		}
+	};
+	auto wait_for_stage = [&](int expected) {
+		for (int current = stage.load(); current != expected; current = stage.load())
+			stage.wait(current);
+	};
+
+	std::optional<int> read_value;
+	std::jthread reader{ [&] {
+		hashmap_policy::SchedulePointHook::attach(park, &stage);
+		read_value = hmap.read(3);
+		hashmap_policy::SchedulePointHook::attach(nullptr, nullptr);
+	} };
+
+	wait_for_stage(1);
+	grow_fully(hmap, next_key);
+	stage.store(2);
+	stage.notify_all();
+
+	wait_for_stage(3);
+	std::atomic<bool> grown = false;
+	std::jthread writer{ [&] {
+		grow_fully(hmap, next_key);
+		grown = true;
+	} };
+	//	the table reader is in is the one being migrated away, writer has to wait for the reader
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	assert_false(grown.load());
+
+	stage.store(4);
+	stage.notify_all();
+	reader.join();
+	writer.join();
+	assert_true(grown.load());
+	assert_true(read_value == 30);
+
+	//	same race left to chance: readers give way right before joining their group, across many growths
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeGrowableHashMap<int, int, SchedulePointTraits> growing(16);
+	for (int i = -100; i <= -1; ++i)
+		growing.store(i, i * i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = 0; i < 20000; ++i)
+			growing.store(i, i);
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		hashmap_policy::SchedulePointHook::attach([](void*, Point point) {
+			if (point == Point::ReaderEnter)
+				std::this_thread::yield();
+		}, nullptr);
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int key = -1 - repeat % 100;
+			assert_true(growing.read(key) == key * key);
+		}
+		hashmap_policy::SchedulePointHook::attach(nullptr, nullptr);
+	});
+}
+
+//	replica whose construction fails, as if its memory could not be allocated
+struct FailingReplica
+{
+	using key_type = int;
+	using mapped_type = int;
+
+	FailingReplica() { throw std::bad_alloc(); }
+};
+
+//	test - every replica gets every write, failure building a replica reaches the caller
+//		thr1 - keeps overwriting the prefilled keys
+//		thr2..N - read those keys from their local replica, always there with a value of that key
+void test_numa_replicated()
+{
+	//	failure on the thread constructing a replica reaches the caller
+	bool thrown = false;
+	try { NumaReplicatedHashMap<FailingReplica> failing(2); }
+	catch (const std::bad_alloc&) { thrown = true; }
+	assert_true(thrown);
+
+	//	replica per node, single node box gets one
+	NumaReplicatedHashMap<LockFreeFixedSizeHashMap<int, int, 1000>> per_node;
+	assert_true(per_node.replicas_num() >= 1);
+	assert_true(per_node.local_replica_idx() < per_node.replicas_num());
+
+	//	more replicas than nodes, writes reach every one of them
+	NumaReplicatedHashMap<LockFreeFixedSizeHashMap<int, int, 1000>> hmap(3);
+	assert_eq(int(hmap.replicas_num()), 3);
+	std::map<int, int> expected;
+	for (int repeat = 0; repeat < 5000; ++repeat)
+	{
+		int key = dis(gen);
+		if (repeat % 3 == 2)
+			assert_eq(hmap.remove(key), expected.erase(key) == 1);
+		else
+		{
+			assert_eq(hmap.store(key, repeat), !expected.contains(key));
+			expected[key] = repeat;
+		}
+	}
+	for (size_t replica_idx = 0; replica_idx < hmap.replicas_num(); ++replica_idx)
+	{
+		std::map<int, int> visited;
+		hmap.replica(replica_idx).visit([&](const std::pair<int, int>& item) { visited.insert(item); });
+		assert_true(visited == expected);
+	}
+
+	//	readers on the local replica see values the writer keeps storing
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	for (int key = 1; key <= 100; ++key)
+		hmap.store(key, key * 1000);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = 0; i < 20000; ++i)
+			hmap.store(1 + i % 100, (1 + i % 100) * 1000 + i % 7);
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int key = 1 + repeat % 100;
+			auto value = hmap.read(key);
+			assert_true(value && *value / 1000 == key);
+		}
+	});
+}
+
+//	test - wait_for returns once the key is stored or the timeout is over, wait_for_change once the key changes or goes
+//		thr1..N - waiters, each waits for its own key to be stored
+//		thrN+1 - notifier, stores those keys one after another
+//		then thrN+1 waits for a change of a key, delayed writer thread overwrites it and later removes it
+template<typename Traits>
+void test_wait_for()
+{
+	using namespace std::chrono_literals;
+	LockFreeFixedSizeHashMap<int, int, 100, Traits> hmap;
+
+	//	nobody writes, timeout is over
+	auto start = std::chrono::steady_clock::now();
+	assert_true(hmap.wait_for(1, 20ms) == std::nullopt);
+	assert_true(std::chrono::steady_clock::now() - start >= 20ms);
+
+	//	present key returns right away, even with no time to wait
+	hmap.store(1, 10);
+	assert_true(hmap.wait_for(1, 0ms) == 10);
+
+	//	waiters on different keys are woken by the writer storing those, one after another
+	constexpr size_t c_num_of_waiting_threads = 3;
+	{
+		std::vector<std::jthread> waiters;
+		for (int key = 100; key < 100 + int(c_num_of_waiting_threads); ++key)
+			waiters.emplace_back([&, key] { assert_true(hmap.wait_for(key, 10s) == key * key); });
+
+		std::this_thread::sleep_for(10ms);
+		for (int key = 100; key < 100 + int(c_num_of_waiting_threads); ++key)
+			hmap.store(key, key * key);
+	}
+
+	//	change of value, then removal of the key
+	auto [value, version] = hmap.read_versioned(1);
+	assert_true(value == 10);
+	assert_true(hmap.wait_for_change(1, version, 0ms) == std::nullopt);
+	auto delayed_write = [](auto write) { return std::jthread([write] { std::this_thread::sleep_for(10ms); write(); }); };
+	{
+		auto writer = delayed_write([&] { hmap.store(1, 11); });
+		auto changed = hmap.wait_for_change(1, version, 10s);
+		assert_true(changed && changed->value == 11);
+		version = changed->version;
+	}
+	{
+		auto writer = delayed_write([&] { hmap.remove(1); });
+		auto changed = hmap.wait_for_change(1, version, 10s);
+		assert_true(changed && changed->value == std::nullopt);
+		assert_true(changed->version == hmap.read_versioned(1).version);
+	}
+}
+
+struct EpochTraits : hashmap_policy::DefaultTraits { using Reclamation = hashmap_policy::EpochReclamation<>; };
+
+//	test - store_batch has the same outcome as stores one by one, overfill throws
+//		thr1 - stores batches overwriting the stable keys and adding noise keys, then removes the noise
+//		thr2..N - read the stable keys, both ends of the value always match
+template<typename Traits>
+void test_store_batch()
+{
+	//	same outcome as stores one by one, duplicates in a batch keep the last value
+	LockFreeFixedSizeHashMap<int, int, 1000, Traits> hmap;
+	std::map<int, int> expected;
+	for (int repeat = 0; repeat < 200; ++repeat)
+	{
+		std::vector<std::pair<int, int>> batch;
+		size_t new_keys = 0;
+		std::map<int, int> batch_expected = expected;
+		for (int i = 0; i < 20; ++i)
+		{
+			batch.emplace_back(dis(gen) % 500, repeat * 100 + i);
+			new_keys += batch_expected.insert_or_assign(batch.back().first, batch.back().second).second ? 1 : 0;
+		}
+		assert_eq(int(hmap.store_batch(batch)), int(new_keys));
+		expected = batch_expected;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			int key = dis(gen) % 500;
+			assert_eq(hmap.remove(key), expected.erase(key) == 1);
+		}
+	}
+	std::map<int, int> visited;
+	hmap.visit([&](const std::pair<int, int>& item) { visited.insert(item); });
+	assert_true(visited == expected);
+
+	//	overfill throws, whatever got stored is stored right
+	LockFreeFixedSizeHashMap<int, int, 100, Traits> small;
+	std::vector<std::pair<int, int>> batch;
+	for (int key = 0; key < 150; ++key)
+		batch.emplace_back(key, key * 2);
+	bool thrown = false;
+	try { small.store_batch(batch); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+	int stored = 0;
+	small.visit([&](const std::pair<int, int>& item) { assert_eq(item.second, item.first * 2); ++stored; });
+	assert_true(stored <= 100);
+
+	//	readers of the stable keys never see a half written value, while batches overwrite them and churn noise keys around
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeFixedSizeHashMap<int, WideValue, 300, Traits> wide;
+	for (int key = 0; key < 100; ++key)
+		wide.store(key, WideValue(key));
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 2000; ++repeat)
+		{
+			std::vector<std::pair<int, WideValue>> wide_batch;
+			for (int i = 0; i < 10; ++i)
+			{
+				wide_batch.emplace_back(dis(gen) % 100, WideValue(dis(gen) * 100));
+				wide_batch.back().second = WideValue(wide_batch.back().second.fields[0] + wide_batch.back().first);
+				wide_batch.emplace_back(1000 + dis(gen) % 100, WideValue(repeat));
+			}
+			wide.store_batch(wide_batch);
+			for (int key = 1000; key < 1100; ++key)
+				wide.remove(key);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			auto ends = wide.read_with(repeat % 100, [](const WideValue& value) { return std::make_pair(value.fields[0], value.fields[63]); });
+			assert_true(ends.has_value());
+			assert_eq(ends->first, ends->second);
+			assert_eq(ends->first % 100, repeat % 100);
+		}
+	});
+}
+
+template<typename ReclamationPolicy>
+struct SortedIndexTraits : hashmap_policy::DefaultTraits
+{
+	using Reclamation = ReclamationPolicy;
+	using Index = hashmap_policy::SkipListIndex<>;
+};
+
+//	test - sorted index stays in key order through every way of writing, range visits match std::map
+//		thr1 - overwrites the stable keys and churns noise keys in between them
+//		thr2..N - visit a range, see every stable key in it once, in order, never torn
+template<typename ReclamationPolicy>
+void test_sorted_index()
+{
+	using Traits = SortedIndexTraits<ReclamationPolicy>;
+
+	//	every way of writing keeps the index in order
+	LockFreeFixedSizeHashMap<int, int, 1000, Traits> hmap;
+	std::map<int, int> expected;
+	for (int repeat = 0; repeat < 5000; ++repeat)
+	{
+		int key = dis(gen);
+		switch (repeat % 4)
+		{
+		case 0:
+			hmap.store(key, repeat);
+			expected[key] = repeat;
+			break;
+		case 1:
+			hmap.store_batch(std::vector<std::pair<int, int>>{ { key, repeat }, { key + 1, repeat } });
+			expected[key] = expected[key + 1] = repeat;
+			break;
+		case 2:
+			hmap.compute(key, [&](const int*) { return std::optional<int>(repeat); });
+			expected[key] = repeat;
+			break;
+		default:
+			assert_eq(hmap.remove(key), expected.erase(key) == 1);
+		}
+	}
+
+	std::vector<std::pair<int, int>> visited;
+	hmap.visit_sorted([&](const std::pair<int, int>& item) { visited.push_back(item); });
+	assert_true(visited == std::vector<std::pair<int, int>>(expected.begin(), expected.end()));
+
+	for (int repeat = 0; repeat < 100; ++repeat)
+	{
+		int lo = dis(gen), hi = lo + dis(gen) % 100;
+		visited.clear();
+		hmap.visit_range(lo, hi, [&](const std::pair<int, int>& item) { visited.push_back(item); });
+		assert_true(visited == std::vector<std::pair<int, int>>(expected.lower_bound(lo), expected.upper_bound(hi)));
+	}
+
+	LockFreeFixedSizeHashMap<int, int, 1000, Traits> loaded;
+	loaded.bulk_load(expected);
+	visited.clear();
+	loaded.visit_sorted([&](const std::pair<int, int>& item) { visited.push_back(item); });
+	assert_true(visited == std::vector<std::pair<int, int>>(expected.begin(), expected.end()));
+
+	//	readers scanning a range see every stable key in it, once, in order, never torn - while writer overwrites them and
+	//	churns keys in between
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeFixedSizeHashMap<int, WideValue, 300, Traits> wide;
+	for (int key = 0; key < 1000; key += 10)
+		wide.store(key, WideValue(key));
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			int noise_key = dis(gen) % 1000 / 10 * 10 + 5;
+			if (!wide.remove(noise_key))
+				wide.store(noise_key, WideValue(noise_key));
+			int stable_key = dis(gen) % 100 * 10;
+			wide.store(stable_key, WideValue(stable_key + repeat * 1000));
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 500; ++repeat)
+		{
+			int previous_key = 190, stable_keys = 0;
+			wide.visit_range(200, 800, [&](const std::pair<int, WideValue>& item) {
+				assert_true(item.first > previous_key);
+				assert_eq(item.second.fields[0], item.second.fields[63]);
+				assert_eq(item.second.fields[0] % 1000, item.first);
+				if (item.first % 10 == 0)
+				{
+					assert_eq(item.first, previous_key / 10 * 10 + 10);
+					++stable_keys;
+				}
+				previous_key = item.first;
+			});
+			assert_eq(stable_keys, 61);
+		}
+	});
+}
+
+//	test - bulk loaded map is the same as one filled by stores, only a fresh map takes a bulk load that fits
+template<typename Traits>
+void test_bulk_load()
+{
+	//	duplicates keep the last value, like stores would
+	std::vector<std::pair<int, int>> items;
+	for (int i = 0; i < 900; ++i)
+		items.emplace_back(i, i);
+	for (int i = 0; i < 100; ++i)
+		items.emplace_back(i * 3, -i);
+
+	auto expected = [](int key) { return key % 3 == 0 && key < 300 ? -key / 3 : key; };
+
+	LockFreeFixedSizeHashMap<int, int, 1000, Traits> hmap;
+	hmap.bulk_load(items);
+	for (int i = 0; i < 900; ++i)
+		assert_true(hmap.read(i) == expected(i));
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>&) { ++visited; });
+	assert_eq(visited, 900);
+
+	//	allocator knows which nodes are taken: exactly 100 more keys fit
+	for (int i = 900; i < 1000; ++i)
+		assert_true(hmap.store(i, i));
+	bool thrown = false;
+	try { hmap.store(1000, 0); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+
+	//	removed and reinserted keys go through the usual paths
+	for (int i = 0; i < 1000; i += 2)
+		assert_true(hmap.remove(i));
+	for (int i = 0; i < 1000; ++i)
+		assert_true(hmap.read(i) == (i % 2 == 0 ? std::nullopt : std::optional<int>(expected(i))));
+	for (int i = 0; i < 1000; i += 2)
+		assert_true(hmap.store(i, -i));
+	assert_true(hmap.read(998) == -998);
+
+	//	only a fresh map may be bulk loaded, and only with what fits
+	thrown = false;
+	try { hmap.bulk_load(items); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+
+	LockFreeFixedSizeHashMap<int, int, 100, Traits> small;
+	thrown = false;
+	try { small.bulk_load(items); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+	assert_true(small.store(1, 1));
+}
+
+//	test - upsert, store_if_absent, remove_if and compute, then in place updates under readers
+//		thr1 - keeps incrementing both halves of the same few values through upsert
+//		thr2..N - read those values, halves are always equal
+template<typename Traits>
+void test_read_modify_write()
+{
+	LockFreeFixedSizeHashMap<int, int, 100, Traits> hmap;
+	assert_true(hmap.upsert(1, [](int& value) { value += 5; }));
+	assert_false(hmap.upsert(1, [](int& value) { value *= 2; }));
+	assert_true(hmap.read(1) == 10);
+
+	assert_true(hmap.store_if_absent(2, 20));
+	assert_false(hmap.store_if_absent(2, 30));
+	assert_true(hmap.read(2) == 20);
+
+	assert_false(hmap.remove_if(2, [](int value) { return value > 20; }));
+	assert_true(hmap.remove_if(2, [](int value) { return value == 20; }));
+	assert_false(hmap.remove_if(2, [](int) { return true; }));
+	assert_true(hmap.read(2) == std::nullopt);
+
+	if constexpr (!Traits::Writers::Concurrent)
+	{
+		auto increment_or_drop = [](const int* value) { return value && *value >= 11 ? std::nullopt : std::optional<int>(value ? *value + 1 : 0); };
+		assert_true(hmap.compute(3, increment_or_drop) == 0);
+		assert_true(hmap.compute(1, increment_or_drop) == 11);
+		assert_true(hmap.compute(1, increment_or_drop) == std::nullopt);
+		assert_true(hmap.read(1) == std::nullopt);
+		assert_true(hmap.read(3) == 0);
+		assert_true(hmap.compute(4, [](const int*) { return std::optional<int>(); }) == std::nullopt);
+		assert_true(hmap.read(4) == std::nullopt);
+	}
+
+	//	counters updated in place under readers, which never see a torn value: both halves are always equal
+	struct Pair { int64_t a; int64_t b; };
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeFixedSizeHashMap<int, Pair, 100, Traits> counters;
+	for (int key = 0; key < 10; ++key)
+		counters.store(key, Pair{ 0, 0 });
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+			counters.upsert(repeat % 10, [](Pair& pair) { ++pair.a; ++pair.b; });
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 20000; ++repeat)
+		{
+			auto pair = counters.read(repeat % 10);
+			assert_true(pair && pair->a == pair->b);
+		}
+	});
+
+	thr1.join();
+	for (auto& reader : reader_threads)
+		reader.join();
+	for (int key = 0; key < 10; ++key)
+		assert_true(counters.read(key)->a == 2000);
+}
+
+//	test - increments of the same keys through upsert from many writers are never lost
+//		thr1..N - each increments the same 10 keys
+void test_multi_writer_upsert()
+{
+	//	increments of the same keys from many writers are never lost
+	LockFreeFixedSizeHashMap<int, int, 100, MultiWriterTraits> hmap;
+	auto writer_threads = spawn_n_of<4>([&] mutable {
+		for (int repeat = 0; repeat < 10000; ++repeat)
+			hmap.upsert(repeat % 10, [](int& value) { ++value; });
+	});
+	for (auto& writer : writer_threads)
+		writer.join();
+	for (int key = 0; key < 10; ++key)
+		assert_true(hmap.read(key) == 4000);
+}
+
+struct AtomicSlotsTraits : hashmap_policy::DefaultTraits { using NodeLayout = hashmap_policy::AtomicSlots; };
+
+//	test - atomic slots layout matches std::map through random stores and removes, wide pairs fall back
+//		thr1 - keeps overwriting the same few keys and churning keys around them
+//		thr2..N - read those keys, halves of the value are always equal
+void test_atomic_slots()
+{
+	LockFreeFixedSizeHashMap<int, int, 100, AtomicSlotsTraits> hmap;
+	std::map<int, int> expected;
+	for (int repeat = 0; repeat < 20000; ++repeat)
+	{
+		int key = dis(gen) % 150;
+		if (repeat % 3 == 2)
+			assert_eq(hmap.remove(key), expected.erase(key) == 1);
+		else if (expected.size() < 100 || expected.contains(key))
+		{
+			assert_eq(hmap.store(key, repeat), !expected.contains(key));
+			expected[key] = repeat;
+		}
+	}
+	for (int key = 0; key < 150; ++key)
+	{
+		auto it = expected.find(key);
+		assert_true(hmap.read(key) == (it == expected.end() ? std::nullopt : std::optional<int>(it->second)));
+	}
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>& keyval) { assert_eq(keyval.second, expected[keyval.first]); ++visited; });
+	assert_eq(visited, int(expected.size()));
+
+	LockFreeFixedSizeHashMap<int, int, 10, AtomicSlotsTraits> small;
+	for (int i = 0; i < 10; ++i)
+		assert_true(small.store_if_absent(i, i));
+	assert_false(small.store_if_absent(5, 0));
+	bool thrown = false;
+	try { small.store(10, 0); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+
+	//	pairs larger than 16 bytes fall back to the general map
+	LockFreeFixedSizeHashMap<int, WideValue, 10, AtomicSlotsTraits> wide;
+	wide.store(1, WideValue(7));
+	assert_true(wide.read_with(1, [](const WideValue& value) { return value.fields[63]; }) == 7);
+
+	//	readers never see a torn value: both halves are always equal
+	struct Halves { int32_t a; int32_t b; };
+	constexpr size_t c_num_of_reading_threads = 3;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	LockFreeFixedSizeHashMap<int64_t, Halves, 100, AtomicSlotsTraits> halves;
+	for (int64_t key = 0; key < 10; ++key)
+		halves.store(key, Halves{ 0, 0 });
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int32_t repeat = 0; repeat < 100000; ++repeat)
+		{
+			halves.store(repeat % 10, Halves{ repeat, repeat });
+			//	keys coming and going around the steady ones
+			halves.store(100 + repeat % 50, Halves{ repeat, repeat });
+			if (repeat >= 20)
+				halves.remove(100 + (repeat - 20) % 50);
+		}
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		for (int repeat = 0; repeat < 100000; ++repeat)
+		{
+			auto value = halves.read(repeat % 10);
+			assert_true(value && value->a == value->b);
+		}
+	});
+}
+
+//	test - snapshot is a consistent cut of the map, a stalled one gives up instead of blocking the writer
+//		thr1 - slides a window of keys, stores the next one and removes the oldest
+//		thr2 - keeps taking snapshots, keys in each of them are contiguous
+void test_snapshot_consistency()
+{
+	//	writer slides a window of 100 keys: stores the next key, then removes the oldest one.
+	//	Between any two writes present keys are contiguous, visit() might see a gap or an extra key - snapshot() never.
+	constexpr int c_window = 100;
+	std::atomic<int> start_counter = 2;
+	std::atomic<bool> writing = true;
+	LockFreeFixedSizeHashMap<int, int, 1000> hmap;
+	for (int i = 0; i < c_window; ++i)
+		hmap.store(i, i);
+
+	std::jthread thr1{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = c_window; i < 200000; ++i)
+		{
+			hmap.store(i, i);
+			hmap.remove(i - c_window);
+		}
+		writing = false;
+	} };
+
+	SYNC_START_THREADS();
+	size_t snapshots_num = 0;
+	size_t previous_generation = 0;
+	while (writing || snapshots_num == 0)
+	{
+		auto snapshot = hmap.snapshot();
+		if (!snapshot)
+			continue;
+		assert_true(snapshot->generation >= previous_generation);
+		previous_generation = snapshot->generation;
+
+		std::ranges::sort(snapshot->items);
+		const int size = int(snapshot->items.size());
+		assert_true(size == c_window || size == c_window + 1);
+		for (int i = 0; i < size; ++i)
+		{
+			assert_eq(snapshot->items[i].first, snapshot->items[0].first + i);
+			assert_eq(snapshot->items[i].second, snapshot->items[i].first);
+		}
+		++snapshots_num;
+	}
+	thr1.join();
+
+	//	snapshot stalled in the middle of its scan holds nobody up, its copy is thrown away
+	LockFreeFixedSizeHashMap<int, int, 1000, SchedulePointTraits> stalled;
+	for (int i = 0; i < c_window; ++i)
+		stalled.store(i, i);
+
+	//	0 - scanning, 1 - parked, 2 - going on
+	std::atomic<int> stage = 0;
+	std::optional<LockFreeFixedSizeHashMap<int, int, 1000, SchedulePointTraits>::Snapshot> stalled_snapshot;
+	std::jthread reader{ [&] {
+		hashmap_policy::SchedulePointHook::attach([](void* context, hashmap_policy::SchedulePoint point) {
+			std::atomic<int>& stage = *static_cast<std::atomic<int>*>(context);
+			if (point == hashmap_policy::SchedulePoint::NodeRead && stage.load() == 0)
+			{
+				stage.store(1);
+				stage.notify_all();
+				stage.wait(1);
+			}
+		}, &stage);
+		stalled_snapshot = stalled.snapshot(1);
+		hashmap_policy::SchedulePointHook::attach(nullptr, nullptr);
+	} };
+
+	stage.wait(0);
+	for (int i = c_window; i < 2 * c_window; ++i)
+	{
+		assert_true(stalled.store(i, i));
+		assert_true(stalled.remove(i - c_window));
+	}
+	stage.store(2);
+	stage.notify_all();
+	reader.join();
+	assert_false(stalled_snapshot.has_value());
+	assert_eq(int(stalled.snapshot()->items.size()), c_window);
+}
+
+//	test - snapshot saved to a file is sorted by key and loads back into an equal map, other layout is refused
+void test_snapshot_file()
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "lffs_test_snapshot.snap").string();
+
+	LockFreeFixedSizeHashMap<int, WideValue, 1000> hmap;
+	for (int i = 0; i < 500; ++i)
+		hmap.store(i, WideValue(i));
+	hmap.remove(7);
+	const size_t generation = save_snapshot(hmap, path);
+	assert_eq(int(generation), 501);
+
+	auto file = SnapshotFile<int, WideValue>::open(path);
+	assert_eq(int(file.header().records_num), 499);
+	assert_true(std::ranges::is_sorted(file.records(), {}, [](const auto& record) { return record.key; }));
+	assert_eq(file.records().front().key, 0);
+
+	LockFreeFixedSizeHashMap<int, WideValue, 1000> restored;
+	assert_eq(int(load_snapshot(restored, path)), 499);
+	for (int i = 0; i < 500; ++i)
+	{
+		auto last_field = restored.read_with(i, [](const WideValue& value) { return value.fields[63]; });
+		assert_true(last_field == (i == 7 ? std::nullopt : std::optional<int>(i)));
+	}
+
+	//	file of a different layout is refused
+	bool thrown = false;
+	try { SnapshotFile<int, int>::open(path); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+
+	std::filesystem::remove(path);
+}
+
+//	-----------------------------------
+
+//	Deterministic schedules. All keys share two buckets, so removes unlink nodes from the middle of the chains
+//	readers walk, and nodes get reused for other keys under them.
+struct CollidingHash
+{
+	size_t operator()(int key) const { return size_t(key) % 2; }
+};
+
+struct ScheduledTraits : hashmap_policy::DefaultTraits
+{
+	template<typename K>
+	using Hash = CollidingHash;
+	using Schedule = hashmap_policy::SchedulePointHook;
+};
+
+struct ScheduledMultiWriterTraits : ScheduledTraits { using Writers = hashmap_policy::MultiWriter; };
+
+//	Value written one half at a time by the tests below, a reader may catch it half written
+struct SplitValue
+{
+	int low = 0;
+	int high = 0;
+
+	auto operator<=>(const SplitValue&) const = default;
+};
+
+//	test - checker itself, histories known to be (not) linearizable
+void test_linearizability_checker()
+{
+	using History = LinearizabilityHistory<int, int>;
+	auto throws = [](const History& history) {
+		try { history.check(); }
+		catch (const std::runtime_error&) { return true; }
+		return false;
+	};
+
+	//	read missed the key stored before it was called
+	History stale;
+	stale.return_from(stale.call({ History::Kind::Store, 1, 10 }), [](auto& op) { op.succeeded = true; });
+	stale.return_from(stale.call({ History::Kind::Read, 1 }), [](auto& op) { op.read_value = std::nullopt; });
+	assert_true(throws(stale));
+
+	//	same, but overlapping - read might have gone first
+	History overlapping;
+	const size_t store_idx = overlapping.call({ History::Kind::Store, 1, 10 });
+	const size_t read_idx = overlapping.call({ History::Kind::Read, 1 });
+	overlapping.return_from(store_idx, [](auto& op) { op.succeeded = true; });
+	overlapping.return_from(read_idx, [](auto& op) { op.read_value = std::nullopt; });
+	assert_false(throws(overlapping));
+
+	//	value never stored (torn read)
+	History torn(std::map<int, int>{ { 1, 10 } });
+	torn.return_from(torn.call({ History::Kind::Read, 1 }), [](auto& op) { op.read_value = 11; });
+	assert_true(throws(torn));
+
+	//	two threads without schedule points: only the order they start in differs
+	DeterministicScheduler scheduler;
+	assert_eq(int(scheduler.explore_bounded(2, 100, [](DeterministicScheduler& schedule) { schedule.run({ [] {}, [] {} }); })), 2);
+}
+
+//	test - writer(s) and readers under random schedules, every history has to be linearizable
+template<typename Traits>
+void test_random_schedules()
+{
+	using Map = LockFreeFixedSizeHashMap<int, int, 16, Traits>;
+	constexpr size_t c_schedules_num = 20;
+
+	DeterministicScheduler scheduler;
+	scheduler.explore_random(c_schedules_num, gen(), [](DeterministicScheduler& schedule) {
+		Map hmap;
+		for (int key : { 1, 2, 3, 4 })
+			hmap.store(key, key * 10);
+		LinearizabilityHistory<int, int> history({ { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 } });
+
+		std::vector<DeterministicScheduler::Thread> threads = {
+			[&] { history.store(hmap, 5, 50); history.remove(hmap, 3); history.store(hmap, 1, 11); history.remove(hmap, 5); history.store(hmap, 3, 31); },
+			[&] { for (int key : { 1, 3, 5 }) history.read(hmap, key); },
+			[&] { for (int key : { 5, 3, 1 }) history.read(hmap, key); },
+		};
+		if constexpr (Traits::Writers::Concurrent)
+			threads.push_back([&] { history.remove(hmap, 1); history.store(hmap, 7, 70); history.store(hmap, 3, 32); });
+
+		schedule.run(threads);
+		history.check();
+	});
+}
+
+//	test - every schedule of a writer reusing the node a reader stands on, up to 2 preemptions
+void test_bounded_schedules()
+{
+	using Map = LockFreeFixedSizeHashMap<int, int, 16, ScheduledTraits>;
+
+	DeterministicScheduler scheduler;
+	scheduler.explore_bounded(2, 2000, [](DeterministicScheduler& schedule) {
+		Map hmap;
+		for (int key : { 1, 3 })
+			hmap.store(key, key * 10);
+		LinearizabilityHistory<int, int> history({ { 1, 10 }, { 3, 30 } });
+
+		//	3 is the root of the chain, its node goes to 5
+		schedule.run({
+			[&] { history.remove(hmap, 3); history.store(hmap, 5, 50); },
+			[&] { history.read(hmap, 1); history.read(hmap, 5); },
+		});
+		history.check();
+	});
+
+	//	update in place, with a schedule point between the halves - the reader must never return half of the old value
+	//	and half of the new one
+	using SplitMap = LockFreeFixedSizeHashMap<int, SplitValue, 16, ScheduledTraits>;
+	scheduler.explore_bounded(2, 2000, [](DeterministicScheduler& schedule) {
+		SplitMap hmap;
+		hmap.store(1, SplitValue{ 10, 10 });
+		using History = LinearizabilityHistory<int, SplitValue>;
+		History history({ { 1, SplitValue{ 10, 10 } } });
+
+		schedule.run({
+			[&] {
+				const size_t op_idx = history.call({ History::Kind::Store, 1, SplitValue{ 20, 20 } });
+				const bool inserted = hmap.upsert(1, [](SplitValue& value) {
+					value.low = 20;
+					ScheduledTraits::Schedule::point(hashmap_policy::SchedulePoint::NodeWrite);
+					value.high = 20;
+				});
+				history.return_from(op_idx, [&](History::Operation& op) { op.succeeded = inserted; });
+			},
+			[&] { history.read(hmap, 1); history.read(hmap, 1); },
+		});
+		history.check();
+	});
+}
+
+template<typename EvictionPolicy>
+struct EvictionTraits : hashmap_policy::DefaultTraits
+{
+	using Eviction = EvictionPolicy;
+	using Stats = hashmap_policy::CountingStats;
+};
+
+//	test - full map evicts a key instead of overflowing, keys read since the last sweep are spared
+void test_clock_eviction()
+{
+	constexpr int c_capacity = 64;
+	LockFreeFixedSizeHashMap<int, int, c_capacity, EvictionTraits<hashmap_policy::ClockEviction<>>> hmap;
+	for (int i = 0; i < c_capacity; ++i)
+		hmap.store(i, i * i);
+
+	//	every key is fresh, hand clears all of the bits and comes back to the first node
+	assert_true(hmap.store(c_capacity, 0));
+	assert_true(hmap.read(0) == std::nullopt);
+
+	//	keys read meanwhile are spared, the first one nobody read goes
+	for (int i = 1; i < c_capacity / 2; ++i)
+		assert_true(hmap.read(i) == i * i);
+	assert_true(hmap.store(c_capacity + 1, 0));
+	assert_true(hmap.read(c_capacity / 2) == std::nullopt);
+	for (int i = 1; i < c_capacity / 2; ++i)
+		assert_true(hmap.read(i) == i * i);
+
+	//	stream of new keys never overflows, key read in between stores is never evicted
+	for (int i = c_capacity + 2; i < 10000; ++i)
+	{
+		hmap.store(i, i * i);
+		assert_true(hmap.read(7) == 49);
+	}
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>&) { ++visited; });
+	assert_eq(visited, c_capacity);
+	assert_eq(int(hmap.stats().overflows), 0);
+	assert_eq(int(hmap.stats().evictions), 10000 - c_capacity);
+}
+
+//	Clock moved by the test only
+struct ManualClock
+{
+	using duration = std::chrono::milliseconds;
+	using rep = duration::rep;
+	using period = duration::period;
+	using time_point = std::chrono::time_point<ManualClock>;
+	static constexpr bool is_steady = true;
+
+	static time_point now() { return time_point(duration(ticks.load())); }
+	static void advance(duration by) { ticks += by.count(); }
+
+	static inline std::atomic<rep> ticks = 0;
+};
+
+//	test - expired key is gone for the readers right away, its node is taken back by evict_expired or a new store
+void test_eviction_time_to_live()
+{
+	using namespace std::chrono_literals;
+	LockFreeFixedSizeHashMap<int, int, 16, EvictionTraits<hashmap_policy::ClockEviction<50, ManualClock>>> hmap;
+	hmap.store(1, 10);
+	hmap.store(2, 20);
+	assert_true(hmap.read(1) == 10);
+	ManualClock::advance(49ms);
+	assert_true(hmap.read(1) == 10);
+
+	//	store starts the time to live over
+	hmap.store(2, 21);
+	ManualClock::advance(1ms);
+	assert_true(hmap.read(1) == std::nullopt);
+	assert_true(hmap.read(2) == 21);
+	int visited = 0;
+	hmap.visit([&](const std::pair<int, int>& keyval) { assert_eq(keyval.first, 2); ++visited; });
+	assert_eq(visited, 1);
+
+	//	expired key is gone only from the readers' view until evicted, its node is taken back then
+	assert_eq(int(hmap.evict_expired()), 1);
+	assert_eq(int(hmap.stats().evictions), 1);
+	assert_false(hmap.remove(1));
+	assert_true(hmap.store(1, 11));
+	assert_true(hmap.read(1) == 11);
+
+	//	full map of expired keys takes new ones
+	ManualClock::advance(60ms);
+	for (int i = 100; i < 116; ++i)
+		assert_true(hmap.store(i, i));
+	assert_eq(int(hmap.stats().overflows), 0);
+	assert_eq(int(hmap.evict_expired()), 0);
+
+	//	real clock, margin wide enough for any loaded box: key stored just now is there, expiry itself is covered above
+	LockFreeFixedSizeHashMap<int, int, 16, EvictionTraits<hashmap_policy::ClockEviction<10'000>>> steady;
+	steady.store(1, 10);
+	assert_true(steady.read(1) == 10);
+	assert_eq(int(steady.evict_expired()), 0);
+}
+
+//	test - keys evicted under readers are never seen with another key's value
+//		thr1 - stores ten times more keys than fit, evicting all the time
+//		thr2..N - read random keys, either missing or with the value of that key
+void test_eviction_vs_readers()
+{
+	constexpr int c_capacity = 100;
+	constexpr size_t c_num_of_reading_threads = 5;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	std::atomic<bool> writer_done = false;
+
+	LockFreeFixedSizeHashMap<int, int, c_capacity, EvictionTraits<hashmap_policy::ClockEviction<>>> hmap;
+
+	std::jthread writer{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = 0; i < 20000; ++i)
+			hmap.store(i % 1000, i % 1000 * 3);
+		writer_done = true;
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		while (!writer_done)
+		{
+			//	any key might be evicted under the reader, but never seen with another key's value
+			const int key = dis(gen) - 1;
+			const std::optional<int> value = hmap.read(key);
+			assert_true(!value || *value == key * 3);
+		}
+	});
+
+	writer.join();
+	for (auto& reader : reader_threads)
+		reader.join();
+	assert_eq(int(hmap.stats().overflows), 0);
+}
+
+//	test - keys and values of any length, slabs are reused and nothing leaks, failed store changes nothing
+void test_var_len_basics()
+{
+	using Map = LockFreeVarLenHashMap<100, 64 * 1024>;
+	auto hmap = std::make_unique<Map>();
+
+	assert_true(hmap->store("EURUSD", "Euro / US Dollar"));
+	assert_true(hmap->read("EURUSD") == "Euro / US Dollar");
+	assert_true(hmap->read("EURUSDX") == std::nullopt);
+
+	//	overwrite with a longer value goes into another slab, the old one is freed
+	const std::string long_value(1000, 'e');
+	assert_false(hmap->store("EURUSD", long_value));
+	assert_true(hmap->read("EURUSD") == long_value);
+	char buffer[4];
+	assert_true(hmap->read("EURUSD", buffer) == 1000);
+	assert_true(std::string_view(buffer, 4) == "eeee");
+
+	//	empty key and value are just as fine
+	assert_true(hmap->store("", ""));
+	assert_true(hmap->read("") == "");
+
+	int visited = 0;
+	hmap->visit([&](std::string_view key, std::string_view value) {
+		assert_true((key == "EURUSD" && value == long_value) || (key == "" && value == ""));
+		++visited;
+	});
+	assert_eq(visited, 2);
+
+	assert_true(hmap->remove("EURUSD"));
+	assert_false(hmap->remove("EURUSD"));
+	assert_true(hmap->read("EURUSD") == std::nullopt);
+	assert_true(hmap->remove(""));
+
+	//	slabs are reused, churn of keys and values of any length leaves nothing behind
+	for (int i = 0; i < 10000; ++i)
+	{
+		const std::string key = "key" + std::to_string(i % 50);
+		hmap->store(key, std::string(i % 300, char('a' + i % 26)));
+		if (i % 7 == 0)
+			hmap->remove("key" + std::to_string(i % 13));
+	}
+	for (int i = 0; i < 50; ++i)
+		hmap->remove("key" + std::to_string(i));
+	assert_eq(int(hmap->arena_used()), 0);
+
+	auto expect_throw = [](auto write) {
+		try { write(); }
+		catch (const std::runtime_error&) { return; }
+		assert_true(false);
+	};
+
+	//	failed store leaves the map and the arena as they were
+	hmap->store("kept", "value");
+	const size_t used = hmap->arena_used();
+	expect_throw([&] { hmap->store("long", std::string(Map::MaxLength + 1, 'x')); });
+	using SmallMap = LockFreeVarLenHashMap<100, 1024>;
+	auto small = std::make_unique<SmallMap>();
+	int stored = 0;
+	expect_throw([&] { for (; ; ++stored) small->store(std::to_string(stored), std::string(100, 'v')); });
+	assert_true(stored > 0);
+	for (int i = 0; i < stored; ++i)
+		assert_true(small->read(std::to_string(i)) == std::string(100, 'v'));
+	assert_true(small->read(std::to_string(stored)) == std::nullopt);
+	assert_true(hmap->read("kept") == "value");
+	assert_eq(int(hmap->arena_used()), int(used));
+}
+
+//	test - slabs freed and reused under readers never show a value mixed with another one
+//		thr1 - stores values of changing length under the same few keys and removes them
+//		thr2..N - read those keys as a string and into a buffer, value is always whole
+void test_var_len_vs_readers()
+{
+	constexpr size_t c_num_of_reading_threads = 5;
+	constexpr int c_keys_num = 20;
+	std::atomic<int> start_counter = c_num_of_reading_threads + 1;
+	std::atomic<bool> writer_done = false;
+
+	auto hmap = std::make_unique<LockFreeVarLenHashMap<100, 256 * 1024>>();
+	auto value_of = [](int key, int length) { return std::string(length, char('a' + key)); };
+
+	std::jthread writer{ [&] mutable {
+		SYNC_START_THREADS();
+		for (int i = 0; i < 20000; ++i)
+		{
+			const int key = i % c_keys_num;
+			if (i % 5 == 0)
+				hmap->remove(std::to_string(key));
+			else
+				hmap->store(std::to_string(key), value_of(key, i % 200));
+		}
+		writer_done = true;
+	} };
+
+	auto reader_threads = spawn_n_of<c_num_of_reading_threads>([&] mutable {
+		SYNC_START_THREADS();
+		char buffer[256];
+		while (!writer_done)
+		{
+			//	slabs are freed and reused under the readers, but a value is never seen mixed with another one
+			const int key = dis(gen) % c_keys_num;
+			const std::optional<std::string> value = hmap->read(std::to_string(key));
+			assert_true(!value || *value == value_of(key, int(value->size())));
+
+			const std::optional<size_t> length = hmap->read(std::to_string(key), buffer);
+			assert_true(!length || std::string_view(buffer, *length) == value_of(key, int(*length)));
+		}
+	});
+
+	writer.join();
+	for (auto& reader : reader_threads)
+		reader.join();
+}
+
+//	test - map created in a memory region is readable through another view attached to it, other layout is refused
+void test_var_len_shared_memory()
+{
+	using Map = LockFreeVarLenHashMap<100, 4096>;
+	std::vector<std::byte> region(Map::shared_memory_size() + 64);
+	void* memory = region.data() + (64 - reinterpret_cast<uintptr_t>(region.data()) % 64) % 64;
+
+	Map* writer = Map::create_in(memory, Map::shared_memory_size());
+	writer->store("GBPUSD", "Pound Sterling / US Dollar");
+
+	//	arena is a part of the map, reader sees the bytes through the offsets alone
+	Map* reader = Map::attach_to(memory, Map::shared_memory_size());
+	assert_true(reader->read("GBPUSD") == "Pound Sterling / US Dollar");
+
+	bool thrown = false;
+	try { LockFreeVarLenHashMap<100, 2048>::attach_to(memory, Map::shared_memory_size()); }
+	catch (const std::runtime_error&) { thrown = true; }
+	assert_true(thrown);
+}
 
 void lock_free_hash_map_tests()
 {
@@ -460,4 +2558,60 @@ void lock_free_hash_map_tests()
 	test_non_existing_key();
 	test_visit_in_noise();
 	test_visit_vs_deletes();
+	test_read_batch();
+	test_read_with();
+	test_backoff<hashmap_policy::LinearBackoff>();
+	test_backoff<hashmap_policy::ExponentialBackoff<>>();
+	test_backoff<hashmap_policy::SpinThenYield<>>();
+	test_backoff<hashmap_policy::WaitOnVersion<>>();
+	test_stats();
+	test_epoch_reclamation();
+	test_dynamic_extent();
+	test_growable();
+	test_growable_parked_reader();
+	test_numa_replicated();
+	test_wait_for<hashmap_policy::DefaultTraits>();
+	test_wait_for<MultiWriterTraits>();
+	test_store_batch<hashmap_policy::DefaultTraits>();
+	test_store_batch<MultiWriterTraits>();
+	test_store_batch<EpochTraits>();
+	test_sorted_index<hashmap_policy::ImmediateReuse>();
+	test_sorted_index<hashmap_policy::EpochReclamation<>>();
+	test_bulk_load<hashmap_policy::DefaultTraits>();
+	test_bulk_load<MultiWriterTraits>();
+	test_snapshot_consistency();
+	test_snapshot_file();
+	test_linearizability_checker();
+	test_random_schedules<ScheduledTraits>();
+	test_random_schedules<ScheduledMultiWriterTraits>();
+	test_bounded_schedules();
+	test_clock_eviction();
+	test_eviction_time_to_live();
+	test_eviction_vs_readers();
+	test_var_len_basics();
+	test_var_len_vs_readers();
+	test_var_len_shared_memory();
+	test_node_layout<hashmap_policy::PackedNodes>();
+	test_node_layout<hashmap_policy::AlignedNodes>();
+	test_node_layout<hashmap_policy::SplitNodes>();
+	test_atomic_slots();
+	test_concurrent_allocator();
+	test_concurrent_allocator_nearly_full();
+	test_multi_writer_disjoint_keys();
+	test_multi_writer_same_keys();
+	test_read_modify_write<hashmap_policy::DefaultTraits>();
+	test_read_modify_write<MultiWriterTraits>();
+	test_multi_writer_upsert();
+	test_shared_memory_attach();
+	test_open_addressing_basics();
+	test_open_addressing_other_key_writer_does_not_affect_reader();
+	test_heterogeneous_lookup();
+	test_hasher<hashmap_policy::IntegerMixHash>();
+	test_hasher<hashmap_policy::WyHash>();
+	test_buckets<hashmap_policy::PrimeModulo>();
+	test_buckets<hashmap_policy::PrimeFastRange>();
+	test_buckets<hashmap_policy::PowerOfTwo>();
+#ifdef HAS_FORK
+	test_shared_memory_processes();
+#endif
 }
@@ -1,48 +1,181 @@
 #pragma once
 
 #include <bit>
+#include <new>
 #include <array>
+#include <memory>
 #include <atomic>
+#include <chrono>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <algorithm>
 #include <iostream>
+#include <span>
 #include <optional>
+#include <ranges>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <stdexcept>
 #include <immintrin.h>
 
+#if defined(__linux__)
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#elif defined(_WIN32)
+//	std::min/max would be broken by the macros of windows.h. The defines are taken back, so they don't leak into
+//	the includer - which still gets windows.h without min/max macros, if it wasn't included before.
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#define LFFS_UNDEF_NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#define LFFS_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#if defined(LFFS_UNDEF_NOMINMAX)
+#undef NOMINMAX
+#undef LFFS_UNDEF_NOMINMAX
+#endif
+#if defined(LFFS_UNDEF_WIN32_LEAN_AND_MEAN)
+#undef WIN32_LEAN_AND_MEAN
+#undef LFFS_UNDEF_WIN32_LEAN_AND_MEAN
+#endif
+#pragma comment(lib, "Synchronization.lib")
+#endif
+
 /*
 * Hash map, tailored to be used over shared memory. Properties are:
-*  - Requires trivial Key/Value types (i.e. PODs, containing no allocations or any other pointers into memory)
+*  - Requires trivial Key/Value types (i.e. PODs, containing no allocations or any other pointers into memory),
+*    see LockFreeVarLenHashmap.h for byte string keys and values kept in a slab arena inside of the map
 *  - Fixed size
-*  - Single writer, multiple readers
+*  - Single writer, multiple readers (multiple writers with hashmap_policy::MultiWriter)
 *  - Lock free
 *  - All operations are amortized O(1), however in practice performance will start dropping once container is nearly full
-*  - Throws on overfill
-*  - Supports store (writer), remove (writer), read (reader/writer), visit all nodes (reader/writer)
+*  - Throws on overfill, unless Traits::Eviction makes room by evicting keys
+*  - Supports store (writer), remove (writer), read (reader/writer), batched read (reader/writer), visit all nodes (reader/writer)
+*  - Read-modify-write in a single chain walk (writer): upsert, compute, store_if_absent, remove_if
+*  - store_batch (writer) applies many pairs at once, grouped by bucket, several times cheaper than looped store
+*  - Zero copy read_with/visit_with: projection runs on the value in place, only its result is copied out
+*  - bulk_load (writer) of a fresh map from a range of key/value pairs, much faster than looped store
+*  - Consistent point in time snapshot() (reader), see LockFreeFixedSizeHashmapSnapshot.h for saving it into a file
+*  - wait_for/wait_for_change (reader) block until the key appears or changes, instead of spinning on read()
+*  - Ordered scans visit_range/visit_sorted (reader) over an optional sorted index, see Traits::Index
+*  - Can be constructed inside of a raw memory region (create_in) and attached to from other processes (attach_to),
+*    see LockFreeFixedSizeHashmapShm.h for named shared memory segments
+*  - Capacity is a template parameter, or is given to the constructor with MaxElems = std::dynamic_extent
+*    (see LockFreeGrowableHashmap.h for the map growing on demand)
+*  - Compile time tuning through Traits (see hashmap_policy::DefaultTraits):
+*      NodeLayout - how nodes are laid out in memory, packed (default), cache line aligned or split into hot/cold arrays.
+*                   Or atomic 16 byte slots with wait free reads, for key/value pairs small enough
+*      Writers    - single writer (default) or multiple concurrent writers
+*      Hash       - hasher of the key, std::hash by default. Transparent hashers (`is_transparent`) are called with the lookup key
+*                   as is, otherwise lookup key is converted to K first, so read/remove always hash the same way store did
+*      KeyEqual   - key comparison, std::equal_to<> by default
+*      Buckets    - bucket count and hash to bucket reduction: prime count with modulo (default), prime count with
+*                   multiply-shift (fastrange) reduction, or power of 2 count with Fibonacci hashing
+*      Backoff    - what to do when a node is being changed: linear pause (default), capped exponential pause,
+*                   spin then yield, or block on the node version until writer is done
+*      Stats      - no stats (default), or contention counters exposed through stats()
+*      Reclamation - removed node is reused right away (default), or only once no reader can be standing on it (epochs),
+*                   so readers never derail and restart (single writer only)
+*      Index      - no sorted index (default), or skip list keeping keys in order for visit_range/visit_sorted (single writer only)
+*      Eviction   - nothing (default), or CLOCK eviction of keys not read lately once the map is full, with an optional
+*                   time to live (single writer only)
+*      Schedule   - nothing (default), or a hook called at every step of the seqlock protocol, so tests can drive the
+*                   interleaving of threads (see LockFreeFixedSizeHashmapStress.h). Not supported by AtomicSlots.
 */
 
 namespace details {
-	//	Memory-less fixed size allocator of size NodesMax
+	//	Size known at compile time, or given at construction for std::dynamic_extent (same convention as std::span)
+	template<size_t N>
+	struct Extent
+	{
+		constexpr explicit Extent([[maybe_unused]] size_t size = N) { assert(size == N); }
+		static constexpr size_t size() { return N; }
+	};
+
+	template<>
+	struct Extent<std::dynamic_extent>
+	{
+		explicit Extent(size_t size) : elems_num(size) {}
+		size_t size() const { return elems_num; }
+
+	private:
+		size_t elems_num;
+	};
+
+	//	Extent of an array of `count(N)` elements
+	constexpr size_t derived_extent(size_t N, size_t count)
+	{
+		return N == std::dynamic_extent ? std::dynamic_extent : count;
+	}
+
+	//	std::array for compile time size, heap allocated array for std::dynamic_extent. Trivial elements start zeroed.
+	template<typename T, size_t N>
+	class FixedArray : public std::array<T, N>
+	{
+	public:
+		explicit FixedArray([[maybe_unused]] size_t size = N)
+		{
+			assert(size == N);
+			if constexpr (std::is_trivially_default_constructible_v<T>)
+				this->fill(T{});
+		}
+	};
+
+	template<typename T>
+	class FixedArray<T, std::dynamic_extent>
+	{
+	public:
+		explicit FixedArray(size_t size) : elems(std::make_unique<T[]>(size)), elems_num(size) {}
+
+		T& operator[](size_t idx) { return elems[idx]; }
+		const T& operator[](size_t idx) const { return elems[idx]; }
+		size_t size() const { return elems_num; }
+
+		T* begin() { return elems.get(); }
+		T* end() { return elems.get() + elems_num; }
+		const T* begin() const { return elems.get(); }
+		const T* end() const { return elems.get() + elems_num; }
+
+	private:
+		std::unique_ptr<T[]> elems;
+		size_t elems_num;
+	};
+
+	//	Memory-less fixed size allocator of size NodesNum (std::dynamic_extent - given at construction)
 	//	each chunk is of ChunkSize. Returns available indexes (i.e. does not own or manage the memory itself).
-	template<size_t NodesMax>
+	template<size_t NodesNum>
 	class FixedAllocator
 	{
 		using BitmaskType = uint64_t;
 		static constexpr size_t BitmaskBits = sizeof(BitmaskType) * 8;
-		static constexpr size_t BitMaskLen = (NodesMax + BitmaskBits - 1) / BitmaskBits;
+		static constexpr size_t BitMaskLen = derived_extent(NodesNum, (NodesNum + BitmaskBits - 1) / BitmaskBits);
 
 	public:
-		static constexpr size_t NodesMax = NodesMax;
+		static constexpr size_t NodesMax = NodesNum;
 
-		FixedAllocator()
+		explicit FixedAllocator(size_t nodes_max = NodesNum)
+			: nodes_num(nodes_max), free_bitmask((nodes_max + BitmaskBits - 1) / BitmaskBits)
 		{
 			//	last byte of free_bitmask should have 1111...0000000 filled to mark unavailable space
-			auto bits_overflow = BitMaskLen * BitmaskBits - NodesMax;
+			auto bits_overflow = free_bitmask.size() * BitmaskBits - nodes_num.size();
 			BitmaskType val = 0;
-			for (auto i = 0; i < bits_overflow; ++i)
+			for (size_t i = 0; i < bits_overflow; ++i)
 				val = (val >> 1) | (BitmaskType(1) << (BitmaskBits - 1));
-			free_bitmask[BitMaskLen - 1] = val;
+			free_bitmask[free_bitmask.size() - 1] = val;
 		}
 
+		size_t nodes_max() const { return nodes_num.size(); }
+
 		size_t alloc()
 		{
 			//	search free in blocks of 64, scanning linearly
@@ -50,7 +183,7 @@ namespace details {
 			while (free_bitmask[last_allocated_free_bitmask_idx] == std::numeric_limits<BitmaskType>::max())
 			{
 				++last_allocated_free_bitmask_idx;
-				last_allocated_free_bitmask_idx %= BitMaskLen;
+				last_allocated_free_bitmask_idx %= free_bitmask.size();
 
 				if (last_allocated_free_bitmask_idx == old_last_allocated_free_bitmask_idx)
 					throw std::runtime_error("Hash map overflow");
@@ -70,7 +203,7 @@ namespace details {
 
 		void free(size_t idx)
 		{
-			assert(idx < NodesMax);
+			assert(idx < nodes_num.size());
 			size_t bitmask_idx = idx / BitmaskBits;
 			size_t bitmask_bit = idx % BitmaskBits;
 			BitmaskType mask = BitmaskType(1) << bitmask_bit;
@@ -79,18 +212,184 @@ namespace details {
 			free_bitmask[bitmask_idx] &= ~mask;
 		}
 
+		//	Marks nodes [0, taken_num) as taken at once, for the bulk load of an empty map
+		void take_first(size_t taken_num)
+		{
+			assert(taken_num <= nodes_num.size());
+			const size_t full_words = taken_num / BitmaskBits;
+			std::fill_n(free_bitmask.begin(), full_words, std::numeric_limits<BitmaskType>::max());
+			if (taken_num % BitmaskBits != 0)
+				free_bitmask[full_words] |= (BitmaskType(1) << (taken_num % BitmaskBits)) - 1;
+
+			last_allocated_free_bitmask_idx = std::min(full_words, free_bitmask.size() - 1);
+		}
+
 	private:
+		[[no_unique_address]] Extent<NodesNum> nodes_num;
 		//	Bitmask of free chunks, for quick alloc/dealloc.
 		//  Lowest bit stores availability of nodes[0], bit 63 encodes availability of -> nodes[63]
 		//  further node's chunks are encoded in the next cells, example free_bitmask[1] & 0x0010 encodes availability of nodes[65]
 		//	0 - free, 1 - taken
-		uint64_t free_bitmask[BitMaskLen] = {};
+		FixedArray<BitmaskType, BitMaskLen> free_bitmask;
 		//	This means where we allocated something, zero - effectively this is where we will be looking for the next chunk again
 		size_t last_allocated_free_bitmask_idx = 0;
 	};
 
+	//	Same as FixedAllocator, but alloc/free are safe to be called concurrently.
+	//	Bits are claimed with atomic fetch_or, so two threads racing for the same free bit are told apart by the returned old value.
+	//
+	//	On top of the bitmask words there is a summary level, one bit per word, set when the word is full. Search for a free node
+	//	skips 64 full words (4096 nodes) per summary word, so nearly full map does not degrade into scanning the whole bitmask.
+	//	Summary is a hint: a word might be marked full for a moment after somebody freed a bit in it, so before giving up
+	//	alloc() falls back to the full scan.
+	//	Every thread starts searching from its own cursor, so concurrent writers don't fight over the same words.
+	template<size_t NodesNum>
+	class ConcurrentFixedAllocator
+	{
+		using BitmaskType = uint64_t;
+		static constexpr size_t BitmaskBits = sizeof(BitmaskType) * 8;
+		static constexpr size_t BitMaskLen = derived_extent(NodesNum, (NodesNum + BitmaskBits - 1) / BitmaskBits);
+		static constexpr size_t SummaryLen = derived_extent(NodesNum, (BitMaskLen + BitmaskBits - 1) / BitmaskBits);
+		static constexpr BitmaskType FullBitmask = std::numeric_limits<BitmaskType>::max();
+
+	public:
+		static constexpr size_t NodesMax = NodesNum;
+
+		explicit ConcurrentFixedAllocator(size_t nodes_max = NodesNum)
+			: nodes_num(nodes_max),
+			free_bitmask((nodes_max + BitmaskBits - 1) / BitmaskBits),
+			full_summary((free_bitmask.size() + BitmaskBits - 1) / BitmaskBits)
+		{
+			//	bits past NodesMax are marked as taken, same for summary bits past the last word
+			const size_t bits_overflow = free_bitmask.size() * BitmaskBits - nodes_num.size();
+			if (bits_overflow != 0)
+				free_bitmask[free_bitmask.size() - 1] = FullBitmask << (BitmaskBits - bits_overflow);
+
+			const size_t summary_bits_overflow = full_summary.size() * BitmaskBits - free_bitmask.size();
+			if (summary_bits_overflow != 0)
+				full_summary[full_summary.size() - 1] = FullBitmask << (BitmaskBits - summary_bits_overflow);
+		}
+
+		size_t nodes_max() const { return nodes_num.size(); }
+
+		size_t alloc()
+		{
+			//	word this thread allocated from the last time, most likely it still has free bits
+			//	(shared by all allocators of this size, so it is just a hint)
+			thread_local size_t thread_cursor = std::hash<std::thread::id>()(std::this_thread::get_id());
+			size_t& cursor = thread_cursor;
+			cursor %= free_bitmask.size();
+
+			size_t idx;
+			if (try_alloc_in(cursor, idx))
+				return idx;
+
+			for (size_t scanned = 0; scanned < full_summary.size(); ++scanned)
+			{
+				const size_t summary_idx = (cursor / BitmaskBits + scanned) % full_summary.size();
+				BitmaskType summary = full_summary[summary_idx].load(std::memory_order_relaxed);
+				while (summary != FullBitmask)
+				{
+					const unsigned not_full_at_bit = std::countr_one(summary);
+					if (try_alloc_in(summary_idx * BitmaskBits + not_full_at_bit, idx))
+					{
+						cursor = summary_idx * BitmaskBits + not_full_at_bit;
+						return idx;
+					}
+
+					//	word turned out to be full, moving on to the next one
+					summary |= BitmaskType(1) << not_full_at_bit;
+				}
+			}
+
+			//	summary might be stale, double check every word before giving up
+			for (size_t bitmask_idx = 0; bitmask_idx < free_bitmask.size(); ++bitmask_idx)
+			{
+				if (try_alloc_in(bitmask_idx, idx))
+					return idx;
+			}
+
+			throw std::runtime_error("Hash map overflow");
+		}
+
+		void free(size_t idx)
+		{
+			assert(idx < nodes_num.size());
+			const size_t bitmask_idx = idx / BitmaskBits;
+			const BitmaskType mask = BitmaskType(1) << (idx % BitmaskBits);
+			//	releases the node to the next owner, and is ordered against summary updates in mark_full()
+			BitmaskType old = free_bitmask[bitmask_idx].fetch_and(~mask, std::memory_order_seq_cst);
+			assert((old & mask) != 0);
+
+			if (old == FullBitmask)
+				full_summary[bitmask_idx / BitmaskBits].fetch_and(~summary_mask(bitmask_idx), std::memory_order_seq_cst);
+		}
+
+		//	Same as FixedAllocator::take_first, not to be called concurrently with alloc/free
+		void take_first(size_t taken_num)
+		{
+			assert(taken_num <= nodes_num.size());
+			const size_t full_words = taken_num / BitmaskBits;
+			for (size_t bitmask_idx = 0; bitmask_idx < full_words; ++bitmask_idx)
+				free_bitmask[bitmask_idx].store(FullBitmask, std::memory_order_relaxed);
+			if (taken_num % BitmaskBits != 0)
+				free_bitmask[full_words].fetch_or((BitmaskType(1) << (taken_num % BitmaskBits)) - 1, std::memory_order_relaxed);
+
+			//	last word might be full now too, if it had only a few nodes past NodesMax
+			for (size_t bitmask_idx = 0; bitmask_idx < std::min(full_words + 1, free_bitmask.size()); ++bitmask_idx)
+			{
+				if (free_bitmask[bitmask_idx].load(std::memory_order_relaxed) == FullBitmask)
+					full_summary[bitmask_idx / BitmaskBits].fetch_or(summary_mask(bitmask_idx), std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		static BitmaskType summary_mask(size_t bitmask_idx) { return BitmaskType(1) << (bitmask_idx % BitmaskBits); }
+
+		bool try_alloc_in(size_t bitmask_idx, size_t& idx)
+		{
+			BitmaskType bitmask = free_bitmask[bitmask_idx].load(std::memory_order_relaxed);
+			while (bitmask != FullBitmask)
+			{
+				const BitmaskType mask = BitmaskType(1) << std::countr_one(bitmask);
+				//	acquires the node from its previous owner (see free())
+				bitmask = free_bitmask[bitmask_idx].fetch_or(mask, std::memory_order_seq_cst);
+				if ((bitmask & mask) == 0)
+				{
+					if ((bitmask | mask) == FullBitmask)
+						mark_full(bitmask_idx);
+
+					idx = bitmask_idx * BitmaskBits + std::countr_zero(mask);
+					return true;
+				}
+
+				//	lost the race for this bit, `bitmask` is fresh now - retry with it
+			}
+
+			//	somebody else filled the word, make sure summary knows
+			mark_full(bitmask_idx);
+			return false;
+		}
+
+		void mark_full(size_t bitmask_idx)
+		{
+			auto& summary = full_summary[bitmask_idx / BitmaskBits];
+			summary.fetch_or(summary_mask(bitmask_idx), std::memory_order_seq_cst);
+
+			//	free() could have cleared the summary bit just before we set it, recheck the word itself
+			if (free_bitmask[bitmask_idx].load(std::memory_order_seq_cst) != FullBitmask)
+				summary.fetch_and(~summary_mask(bitmask_idx), std::memory_order_seq_cst);
+		}
+
+		[[no_unique_address]] Extent<NodesNum> nodes_num;
+		//	same encoding as FixedAllocator::free_bitmask: 0 - free, 1 - taken
+		FixedArray<std::atomic<BitmaskType>, BitMaskLen> free_bitmask;
+		//	bit per free_bitmask word, 1 - word (most likely) is full
+		FixedArray<std::atomic<BitmaskType>, SummaryLen> full_summary;
+	};
+
 	//	round up to the next prime number
-	consteval size_t next_prime(size_t num)
+	constexpr size_t next_prime(size_t num)
 	{
 		if (num <= 5)
 			return 5;
@@ -114,275 +413,310 @@ namespace details {
 			++num;
 		}
 	}
-}
-
-
-template<typename K, typename V, size_t MaxElems>
-	requires std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>
-class LockFreeFixedSizeHashMap
-{
-	static constexpr size_t EmptyBucketTag = std::numeric_limits<size_t>::max();
-	static constexpr size_t BucketsNum = details::next_prime(MaxElems * 2);
 
-public:
-	LockFreeFixedSizeHashMap()
+	//	Fingerprint of a type by its name as the compiler spells it out (FNV-1a). Same for processes built by the same
+	//	compiler and standard library, that's what tells them whether they hash and compare keys the same way.
+	template<typename T>
+	constexpr uint64_t type_fingerprint()
 	{
-		std::fill(buckets.begin(), buckets.end(), EmptyBucketTag);
+#if defined(_MSC_VER) && !defined(__clang__)
+		constexpr std::string_view name = __FUNCSIG__;
+#else
+		constexpr std::string_view name = __PRETTY_FUNCTION__;
+#endif
+		uint64_t h = 0xCBF29CE484222325ULL;
+		for (char c : name)
+		{
+			h ^= uint8_t(c);
+			h *= 0x100000001B3ULL;
+		}
+		return h;
 	}
 
-	void store(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	//	Prefix of the shared memory region, hash map itself is placed right after it (at `map_offset`).
+	//	Describes the layout the writer was compiled with, so readers built against different K/V/MaxElems
+	//	refuse to attach instead of reading garbage.
+	struct SharedMemoryHeader
 	{
-		size_t bucket_idx = std::hash<K>()(key) % BucketsNum;
+		static constexpr uint64_t Magic = 0x50414D485346464CULL;	//	"LFFSHMAP"
+		static constexpr uint32_t LayoutVersion = 5;				//	bump on any change of the Node/map layout
 
-		//	navigate existing bucket's nodes for the key match
-		size_t node_idx = buckets[bucket_idx].load(std::memory_order_relaxed);
-		while (node_idx != EmptyBucketTag)
+		uint64_t magic = Magic;
+		uint32_t layout_version = LayoutVersion;
+		uint32_t map_offset = 0;
+		uint32_t node_layout = 0;	//	Id of the hashmap_policy node layout
+		uint32_t buckets = 0;		//	Id of the hashmap_policy buckets policy
+		uint64_t hash = 0;			//	type_fingerprint of Traits::Hash, keys hashed otherwise land in other buckets
+		uint64_t key_equal = 0;		//	type_fingerprint of Traits::KeyEqual
+		uint64_t key_size = 0;
+		uint64_t value_size = 0;
+		uint64_t max_elems = 0;
+		uint64_t buckets_num = 0;
+		uint64_t map_size = 0;
+		//	set by the writer once map construction is complete
+		std::atomic<uint32_t> ready = 0;
+	};
+
+	//	Readers blocked until a key appears or changes (wait_for/wait_for_change). Buckets are spread over Stripes, every stripe
+	//	has a count of its waiters and a word they sleep on (futex on Linux, WaitOnAddress on Windows, polling elsewhere).
+	//	Writer done with a bucket bumps and wakes the word only if the stripe has waiters - otherwise a write costs a load.
+	//	Lives inside of the map, Linux futexes are not process private, so waiters from other processes are woken too.
+	class KeyWaiters
+	{
+		static constexpr size_t Stripes = 64;
+
+		struct Stripe
+		{
+			std::atomic<uint32_t> changes = 0;
+			std::atomic<uint32_t> waiters = 0;
+		};
+
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		//	Reader. Calls `check()` until it returns something (returned then) or `deadline` passes (last result returned).
+		//	Writes to the buckets of the stripe in between wake the reader up to check again.
+		template<typename F>
+		auto wait(size_t bucket_idx, Clock::time_point deadline, F&& check)
 		{
-			Node& node = nodes[node_idx];
-			if (node.key == key)
+			Stripe& stripe = stripes[bucket_idx % Stripes];
+			stripe.waiters.fetch_add(1, std::memory_order_seq_cst);
+			//	Pairs with the writer's barrier before notify(): either writer sees us waiting, or we see what it wrote
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+
+			while (true)
 			{
-				//	version is odd (readers stay away)
-				node.version.fetch_add(1, std::memory_order_acq_rel);
-				//	update value
-				node.value = std::forward<V>(value);
-				node.part_of_bucket = bucket_idx;
-				//	mark version as even (readers good to go (but may need to reread))
-				node.version.fetch_add(1, std::memory_order_acq_rel);
+				const uint32_t seen_changes = stripe.changes.load(std::memory_order_seq_cst);
+				auto result = check();
+				const auto now = Clock::now();
+				if (result || now >= deadline)
+				{
+					stripe.waiters.fetch_sub(1, std::memory_order_relaxed);
+					return result;
+				}
+
+				sleep_while_equal(stripe.changes, seen_changes, deadline - now);
+			}
+		}
 
+		//	Writer, once its change of the bucket is visible. `bucket_idx` out of range wakes the waiters of all buckets.
+		//	Has to follow a seq_cst read-modify-write (a full barrier on x86, cheaper than a fence on every write):
+		//	either the waiter's count is seen here, or the waiter sees the change.
+		void notify(size_t bucket_idx, size_t buckets_num)
+		{
+			if (bucket_idx < buckets_num)
+			{
+				notify_stripe(stripes[bucket_idx % Stripes]);
 				return;
 			}
 
-			node_idx = node.next_node;
+			for (Stripe& stripe : stripes)
+				notify_stripe(stripe);
 		}
 
-		//	Alloc new node, by doing linked list (new node enters first),
-		//	current root node is pushed down and becomes next node.
-		//	This way, readers can navigate existing chain down safely - new node will just stay invisible
-		node_idx = node_allocator.alloc();
-		Node& node = nodes[node_idx];
-		assert(node.part_of_bucket == EmptyBucketTag);
-		assert(node.next_node == EmptyBucketTag);
-		
-		node.placement_new();
+	private:
+		static void notify_stripe(Stripe& stripe)
+		{
+			if (stripe.waiters.load(std::memory_order_seq_cst) == 0)
+				return;
 
-		node.version.fetch_add(1, std::memory_order_acq_rel);
-		node.key = key;
-		node.value = std::forward<V>(value);
-		node.next_node = buckets[bucket_idx].load(std::memory_order_relaxed);
-		node.part_of_bucket = bucket_idx;
-		node.version.fetch_add(1, std::memory_order_acq_rel);
+			stripe.changes.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+			syscall(SYS_futex, &stripe.changes, FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr, nullptr, 0);
+#elif defined(_WIN32)
+			WakeByAddressAll(&stripe.changes);
+#endif
+		}
 
-		//	At this point we got new node that correctly looks at our root node as next. So readers are oblivious to the addition and
-		//	can navigate existing chain. No existing nodes are updated.
-		//  However now we replace the root of the bucket to make it public.
-		buckets[bucket_idx].store(node_idx, std::memory_order_release);
+		//	Returns on change of `word`, timeout, or spuriously
+		static void sleep_while_equal(std::atomic<uint32_t>& word, uint32_t value, Clock::duration timeout)
+		{
+			const auto timeout_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+#if defined(__linux__)
+			const timespec relative = { time_t(timeout_ns / 1'000'000'000), long(timeout_ns % 1'000'000'000) };
+			syscall(SYS_futex, &word, FUTEX_WAIT, value, &relative, nullptr, 0);
+#elif defined(_WIN32)
+			WaitOnAddress(&word, &value, sizeof(value), DWORD(std::min<long long>(timeout_ns / 1'000'000 + 1, INFINITE - 1)));
+#else
+			if (word.load(std::memory_order_acquire) == value)
+				std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<long long>(timeout_ns, 100'000)));
+#endif
+		}
+
+		alignas(64) std::array<Stripe, Stripes> stripes;
+	};
+
+	//	High half of 128 bit multiplication
+	inline uint64_t mul_high(uint64_t a, uint64_t b)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		return __umulh(a, b);
+#else
+		return uint64_t((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
 	}
 
-	template<typename CompatibleK>
-	std::optional<V> read(const CompatibleK& key)
+	//	128 bit multiplication, folded back into 64 bits
+	inline uint64_t mum(uint64_t a, uint64_t b)
 	{
-		std::optional<V> result;
+#if defined(_MSC_VER) && !defined(__clang__)
+		uint64_t high;
+		uint64_t low = _umul128(a, b, &high);
+		return high ^ low;
+#else
+		unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+		return uint64_t(r >> 64) ^ uint64_t(r);
+#endif
+	}
 
-		size_t bucket_idx = std::hash<CompatibleK>()(key) % BucketsNum;
-		auto do_pause = pause_closure();
+	inline uint64_t read_u64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+	inline uint64_t read_u32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
 
-		//	Do full scan of the bucket.
-		// 
-		//	Internally we scan the existing chain, making sure we didn't derail on the way (i.e. checking deleted/reused nodes).
-		//  It is safe to run over deleted nodes because physically these are not deallocated and stay as a part of `nodes` container, keeping their version value.
-		// 
-		//  If we found the node (key matches, even version, not derailed) - we grab the data and prep to exit.
-		//  Before exit we extra check the node version didn't jump. If so, we must read stale data with possible key/value being overwritten - have to abandon and retry.
-		// 
-		//	However if we didn't find the node - we have to do extra check that our root node was intact.
-		//  Deleter updates bucket's root node if anything inside the chain was modified, to notify readers of the change. Readers cannot detect chain alteration otherwise.
-		//  We cannot recover and have to start scanning the chain from scratch.
-		//
-		while(true)
+	//	wyhash (final version), for keys of any length
+	inline uint64_t wyhash(const void* key, size_t len, uint64_t seed = 0)
+	{
+		constexpr uint64_t s0 = 0xa0761d6478bd642fULL, s1 = 0xe7037ed1a0b428dbULL, s2 = 0x8ebc6af09c88c6e3ULL, s3 = 0x589965cc75374cc3ULL;
+		const uint8_t* p = static_cast<const uint8_t*>(key);
+		seed ^= mum(seed ^ s0, s1);
+
+		uint64_t a, b;
+		if (len <= 16)
 		{
-		l_restart_from_root:
-			//	remember characteristics of the root node, those have to stay the same once we done reading
-			const size_t root_node_idx = buckets[bucket_idx].load(std::memory_order_acquire);
-			if (root_node_idx == EmptyBucketTag)
+			if (len >= 4)
 			{
-				//	Early exit - no root - nothing to worry about
-				result = std::nullopt;
-				return result;
+				a = (read_u32(p) << 32) | read_u32(p + ((len >> 3) << 2));
+				b = (read_u32(p + len - 4) << 32) | read_u32(p + len - 4 - ((len >> 3) << 2));
 			}
-
-			size_t node_idx = root_node_idx;
-			while (node_idx != EmptyBucketTag)
+			else if (len > 0)
 			{
-				//	This part handles only node overwrites, so as far as we found the correct node - we just read and pray it was not overwritten.
-				Node& node = nodes[node_idx];
-				size_t before_version = node.version.load(std::memory_order_acquire);
-				if (before_version % 2 == 1)
-				{
-					//	node is being altered, retrying
-					do_pause();
-					continue;
-				}
-
-				if (node.part_of_bucket != bucket_idx)
-				{
-					//	node was deleted and reused, we got derailed - has to start from the root
-					do_pause();
-					goto l_restart_from_root;
-				}
-
-				//	Another scenario, node was deleted and readded back into the same bucket. We won't see the change
-				//  (version update could have been completed). Though we will be reading node that stays now earlier in the chain.
-				//	This would lead to chain rescan - something that we want anyways. We will miss the most latest added nodes, 
-				//  as those will stay ahead of the node we are rereading. Which is expected.
-
-				if (node.key != key)
-				{
-					const size_t next_node_idx = node.next_node;
-
-					//	consuming data from this node is done, we made a decision
-					//	however we've been assuming so far it was intact
-					//	check if it was true
-					size_t after_version = node.version.load(std::memory_order_acquire);
-					if (before_version == after_version)
-					{
-						node_idx = next_node_idx;
-						continue;
-					}
-					
-					//	if node was updated (say, overwritten) - we need to reread it again
-					do_pause();
-					continue;
-				}
-
-				//	we reach here if node was found, loading data
-				result = node.value;
-
-				//	now, same check were we reading over the same version of the node?
-				size_t after_version = node.version.load(std::memory_order_acquire);
-				if (before_version == after_version)
-				{
-					//	found node and managed to read value fully
-					//	note, we don't mind if anything around us being erased - we're in the correct unaltered node - that's all that matters
-					return result;
-				}
-
-				//	nope, version changed - rereading the node, thus we keep node_idx the same
-				do_pause();
-				continue;
+				a = (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | p[len - 1];
+				b = 0;
 			}
-
-			//	now we fair and square - scanned all, bucket was intact: no such key
-			result = std::nullopt;
-			return result;
+			else
+				a = b = 0;
 		}
-	}
-
-	template<typename CompatibleK>
-	bool remove(const CompatibleK& key)
-	{
-		const size_t bucket_idx = std::hash<CompatibleK>()(key) % BucketsNum;
-		const size_t root_node_idx = buckets[bucket_idx].load(std::memory_order_relaxed);
-		size_t previous_node_idx = EmptyBucketTag;
-		size_t node_idx = root_node_idx;
-		while (node_idx != EmptyBucketTag)
+		else
 		{
-			Node& root_node = nodes[root_node_idx];
-			Node& node = nodes[node_idx];
-			if (node.key == key)
+			size_t left = len;
+			if (left > 48)
 			{
-				//	Relink parent node, now it points to the node after. For reader, the chain is in correct state, and current node looks already deleted.
-				//	If reader didn't yet manage to read old `next_node` link, futher changes will be transparent.
-				//	Note, that readed will have to reread the parent node if it read it during it's update and later detected version change.
-				size_t next_node_idx = node.next_node;
-				if (previous_node_idx != EmptyBucketTag)
-				{
-					Node& previous_node = nodes[previous_node_idx];
-
-					previous_node.version.fetch_add(1, std::memory_order_acq_rel);
-					previous_node.next_node = next_node_idx;
-					previous_node.version.fetch_add(1, std::memory_order_acq_rel);
-				}
-				else
+				uint64_t seed1 = seed, seed2 = seed;
+				do
 				{
-					//	Here we know that being deleted node is the root node.
-					assert(root_node_idx == node_idx);
-					//	Update bucket
-					buckets[bucket_idx].store(next_node_idx, std::memory_order_release);
-				}
-
-				//	Now, mark node as destroyed
-				//	In case if client is reading this node, it might lose the ability to continue, because the next_node info was lost (or even reused).
-				//	In such case, client should detect it derailed seeing `part_of_bucket` mismatch.
-				//	In the edge case when `part_of_bucket` coincides after deletion and reusing - this is the scenario when reader looking at the node that was moved
-				//	back to the beginning of the chain - safe to keep using it.
-				node.version.fetch_add(1, std::memory_order_acq_rel);
-				node.~Node();
-				node.part_of_bucket = EmptyBucketTag;
-				node.next_node = EmptyBucketTag;
-				node.version.fetch_add(1, std::memory_order_acq_rel);
-				node_allocator.free(node_idx);
+					seed = mum(read_u64(p) ^ s1, read_u64(p + 8) ^ seed);
+					seed1 = mum(read_u64(p + 16) ^ s2, read_u64(p + 24) ^ seed1);
+					seed2 = mum(read_u64(p + 32) ^ s3, read_u64(p + 40) ^ seed2);
+					p += 48;
+					left -= 48;
+				} while (left > 48);
+				seed ^= seed1 ^ seed2;
+			}
 
-				return true;
+			while (left > 16)
+			{
+				seed = mum(read_u64(p) ^ s1, read_u64(p + 8) ^ seed);
+				p += 16;
+				left -= 16;
 			}
 
-			previous_node_idx = node_idx;
-			node_idx = node.next_node;
+			a = read_u64(p + left - 16);
+			b = read_u64(p + left - 8);
 		}
 
-		return false;
+		return mum(mum(a ^ s1, b ^ seed) ^ s0 ^ len, s1);
 	}
 
-	template<typename F>	//	func(const std::pair<key, value>&)
-	void visit(F func)
+	//	16 bytes read and written by a single instruction, never torn. Aligned SSE loads/stores are atomic on CPUs with AVX
+	//	(guaranteed by both Intel and AMD), otherwise it takes cmpxchg16b. x86 keeps plain loads/stores ordered (acquire/release),
+	//	only the compiler has to be kept from reordering around them.
+	class alignas(16) Atomic128
 	{
-		//	Visit goes across all nodes only once, this might miss some of the newly inserted nodes.
-		//  Duplicates are possible if node was visited, deleted and then reinserted.
-		for (size_t node_idx = 0; node_idx < MaxElems; ++node_idx)
+	public:
+		template<typename T>
+		T load() const
 		{
-			//	usual pattern, looking after odd version, version change and part_of_bucket value
-			auto do_pause = pause_closure();
+			static_assert(sizeof(T) <= 16 && std::is_trivially_copyable_v<T>);
+			alignas(16) uint64_t words[2];
+#if defined(__AVX__)
+			_mm_store_si128(reinterpret_cast<__m128i*>(words), _mm_load_si128(reinterpret_cast<const __m128i*>(data)));
+#elif defined(_MSC_VER) && !defined(__clang__)
+			words[0] = words[1] = 0;
+			_InterlockedCompareExchange128(const_cast<volatile long long*>(reinterpret_cast<const volatile long long*>(data)), 0, 0, reinterpret_cast<long long*>(words));
+#else
+			//	compares with zero and writes back the same, either way current content ends up in rdx:rax
+			uint64_t low = 0, high = 0;
+			asm volatile("lock cmpxchg16b %2" : "+a"(low), "+d"(high), "+m"(*const_cast<uint64_t(*)[2]>(&data)) : "b"(uint64_t(0)), "c"(uint64_t(0)) : "cc", "memory");
+			words[0] = low;
+			words[1] = high;
+#endif
+			std::atomic_signal_fence(std::memory_order_acquire);
+			T result;
+			std::memcpy(&result, words, sizeof(T));
+			return result;
+		}
 
-			while(true)
+		template<typename T>
+		void store(const T& value)
+		{
+			static_assert(sizeof(T) <= 16 && std::is_trivially_copyable_v<T>);
+			alignas(16) uint64_t words[2] = {};
+			std::memcpy(words, &value, sizeof(T));
+			std::atomic_signal_fence(std::memory_order_release);
+#if defined(__AVX__)
+			_mm_store_si128(reinterpret_cast<__m128i*>(data), _mm_load_si128(reinterpret_cast<const __m128i*>(words)));
+#elif defined(_MSC_VER) && !defined(__clang__)
+			alignas(16) long long expected[2] = { static_cast<long long>(data[0]), static_cast<long long>(data[1]) };
+			while (!_InterlockedCompareExchange128(reinterpret_cast<volatile long long*>(data), words[1], words[0], expected));
+#else
+			uint64_t low = data[0], high = data[1];
+			bool swapped;
+			do
 			{
-				Node& node = nodes[node_idx];
-				size_t before_version = node.version.load(std::memory_order_acquire);
-				if (before_version % 2 == 1)
-				{
-					do_pause();
-					continue;
-				}
+				asm volatile("lock cmpxchg16b %1" : "=@ccz"(swapped), "+m"(data), "+a"(low), "+d"(high) : "b"(words[0]), "c"(words[1]) : "memory");
+			} while (!swapped);
+#endif
+		}
 
-				if (node.part_of_bucket == EmptyBucketTag)
-				{
-					//	empty node, skip..
-					break;
-				}
-
-				std::pair<K, V> pair = std::make_pair(node.key, node.value);
-
-				size_t after_version = node.version.load(std::memory_order_acquire);
-				if (before_version != after_version)
-					continue;
+	private:
+		uint64_t data[2] = {};
+	};
 
-				func(pair);
+	//	Key/value requirement of the maps
+	template<typename K, typename V>
+	concept TriviallyCopyablePair = std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>;
 
-				//	done reading this node
-				break;
-			}
-		}
-	}
-	
-private:
-	struct Node
+	//	Hot part of the node, touched on every hop along the chain
+	struct NodeMeta
 	{
 		//	constantly increasing version
 		//	odd - being changed
 		//  even - ready to read
 		std::atomic<size_t> version = 0;
-		std::atomic<size_t> next_node = EmptyBucketTag;
-		size_t part_of_bucket = EmptyBucketTag;	//	which bucket it belongs to, or -1 if deleted
+		std::atomic<size_t> next_node = std::numeric_limits<size_t>::max();
+		size_t part_of_bucket = std::numeric_limits<size_t>::max();	//	which bucket it belongs to, or -1 if deleted
+	};
+
+	//	User data of the node
+	template<typename K, typename V>
+	struct NodePayload
+	{
 		K key;
 		V value;
+	};
+
+	//	Node as the map sees it, regardless of where node storage keeps its parts
+	template<typename K, typename V>
+	struct NodeRef
+	{
+		NodeRef(NodeMeta& meta, NodePayload<K, V>& payload)
+			: version(meta.version), next_node(meta.next_node), part_of_bucket(meta.part_of_bucket), key(payload.key), value(payload.value)
+		{}
+
+		std::atomic<size_t>& version;
+		std::atomic<size_t>& next_node;
+		size_t& part_of_bucket;
+		K& key;
+		V& value;
 
 		//	placement new of parts of the struct only, we cannot ask version constructor to run - it'd reset the version to zero
 		//	instead, we will initialize only user data
@@ -391,20 +725,2687 @@ private:
 			new (&key) K;
 			new (&value) V;
 		}
+
+		void destroy()
+		{
+			std::destroy_at(&key);
+			std::destroy_at(&value);
+		}
+	};
+}
+
+//	Snapshot of LockFreeFixedSizeHashMap::stats(), counted since the map was constructed
+struct HashMapStats
+{
+	size_t retries = 0;				//	node being changed was seen by reader/writer, had to reread
+	size_t restarts = 0;			//	reader/writer derailed onto a removed node, had to rescan the bucket from the root
+	size_t max_chain_length = 0;	//	longest bucket chain a new node was inserted into
+	size_t overflows = 0;			//	stores thrown on the full map
+	size_t evictions = 0;			//	keys evicted to make room or expired (Traits::Eviction)
+};
+
+namespace hashmap_policy {
+	//	Node layouts. Each provides Storage<K, V, NodesNum> handing out details::NodeRef by index,
+	//	and the address to prefetch before visiting the node. NodesNum might be std::dynamic_extent, size is given at construction then.
+
+	//	Metadata, key and value of the node are packed together, nodes are adjacent. Most compact.
+	//	Writer updating a node invalidates the cache line of its neighbours too.
+	struct PackedNodes
+	{
+		static constexpr uint32_t Id = 0;
+
+		template<typename K, typename V, size_t NodesNum>
+		class Storage
+		{
+			struct Node : details::NodeMeta, details::NodePayload<K, V> {};
+
+		public:
+			explicit Storage(size_t nodes_num = NodesNum) : nodes(nodes_num) {}
+
+			details::NodeRef<K, V> operator[](size_t idx) { return { nodes[idx], nodes[idx] }; }
+			const void* hot_address(size_t idx) const { return &nodes[idx]; }
+
+		private:
+			details::FixedArray<Node, NodesNum> nodes;
+		};
+	};
+
+	//	Same as packed, but every node starts at its own cache line - readers of a node are not disturbed by writes into other nodes.
+	struct AlignedNodes
+	{
+		static constexpr uint32_t Id = 1;
+
+		template<typename K, typename V, size_t NodesNum>
+		class Storage
+		{
+			struct alignas(64) Node : details::NodeMeta, details::NodePayload<K, V> {};
+
+		public:
+			explicit Storage(size_t nodes_num = NodesNum) : nodes(nodes_num) {}
+
+			details::NodeRef<K, V> operator[](size_t idx) { return { nodes[idx], nodes[idx] }; }
+			const void* hot_address(size_t idx) const { return &nodes[idx]; }
+
+		private:
+			details::FixedArray<Node, NodesNum> nodes;
+		};
+	};
+
+	//	Hot metadata (version, links) and cold payload (key, value) live in separate arrays.
+	//	Writer's payload updates do not touch metadata lines, chain walks go over densely packed metadata.
+	struct SplitNodes
+	{
+		static constexpr uint32_t Id = 2;
+
+		template<typename K, typename V, size_t NodesNum>
+		class Storage
+		{
+		public:
+			explicit Storage(size_t nodes_num = NodesNum) : metas(nodes_num), payloads(nodes_num) {}
+
+			details::NodeRef<K, V> operator[](size_t idx) { return { metas[idx], payloads[idx] }; }
+			const void* hot_address(size_t idx) const { return &metas[idx]; }
+
+		private:
+			alignas(64) details::FixedArray<details::NodeMeta, NodesNum> metas;
+			alignas(64) details::FixedArray<details::NodePayload<K, V>, NodesNum> payloads;
+		};
+	};
+
+	//	Key and value together in one 16 byte slot, written and read with a single 128 bit instruction (details::Atomic128).
+	//	Reads are wait free: no version to check, nothing to retry. Slots are open addressed (linear probing, F14 style overflow
+	//	counters instead of tombstones), Buckets policy is not used. Single writer, fixed capacity, no shared memory support.
+	//	Used only if sizeof(K) + sizeof(V) fits 16 bytes, the map falls back to packed nodes otherwise.
+	struct AtomicSlots : PackedNodes
+	{
+		static constexpr uint32_t Id = 3;
+
+		template<typename K, typename V>
+		struct Slot
+		{
+			K key;
+			V value;
+		};
+
+		template<typename K, typename V>
+		static constexpr bool Fits = sizeof(Slot<K, V>) <= 16;
+	};
+
+	//	Writers. Readers are always lock free and unaware of the writers mode.
+
+	//	Only one thread at a time may call store/remove, cheapest.
+	struct SingleWriter
+	{
+		static constexpr bool Concurrent = false;
+
+		template<size_t NodesNum>
+		using Allocator = details::FixedAllocator<NodesNum>;
+	};
+
+	//	Any number of threads may call store/remove concurrently. Writers take exclusive ownership of the nodes they change
+	//	by CAS-ing node version from even (observed) to odd, bucket root is swapped with CAS. Costs extra atomic RMWs per write.
+	struct MultiWriter
+	{
+		static constexpr bool Concurrent = true;
+
+		template<size_t NodesNum>
+		using Allocator = details::ConcurrentFixedAllocator<NodesNum>;
+	};
+
+	//	Hashers. std::hash is identity for integers on most of the implementations - fine for sequential keys,
+	//	but keys sharing a stride with the bucket count end up in a handful of buckets.
+
+	//	xxh3 style avalanche of an integer key, a couple of multiplications
+	struct IntegerMixHash
+	{
+		template<typename T>
+			requires std::is_integral_v<T> || std::is_enum_v<T>
+		size_t operator()(T key) const
+		{
+			uint64_t h = uint64_t(key);
+			h ^= std::rotl(h, 49) ^ std::rotl(h, 24);
+			h *= 0x9FB21C651E98DF25ULL;
+			h ^= (h >> 35) + sizeof(T);
+			h *= 0x9FB21C651E98DF25ULL;
+			return size_t(h ^ (h >> 28));
+		}
+	};
+
+	//	wyhash over the object representation of any trivially copyable key without padding
+	struct WyHash
+	{
+		template<typename T>
+			requires std::has_unique_object_representations_v<T>
+		size_t operator()(const T& key) const
+		{
+			return size_t(details::wyhash(&key, sizeof(T)));
+		}
+	};
+
+	//	Buckets. Each provides count(max_elems) - number of buckets, and index(hash, count) - reduction of the hash to the bucket index.
+	//	Modulo by the compile time count is already turned into multiplications by the compiler, but still costs a few of them
+	//	plus fixups - the alternatives below are a single multiplication (and a shift). With the count known only at runtime
+	//	(std::dynamic_extent maps) modulo is a real division, way slower than those.
+
+	//	Prime count, hash % count. Tolerates weak hashes best (identity std::hash included).
+	struct PrimeModulo
+	{
+		static constexpr uint32_t Id = 0;
+
+		static constexpr size_t count(size_t max_elems) { return details::next_prime(max_elems * 2); }
+		static size_t index(size_t hash, size_t count) { return hash % count; }
+	};
+
+	//	Prime count, Lemire's fastrange: high half of hash * count. Fastrange alone maps by the high bits of the hash,
+	//	so the hash is first multiplied by the golden ratio to spread the low bits up (small integer keys would all go to bucket 0).
+	struct PrimeFastRange
+	{
+		static constexpr uint32_t Id = 1;
+
+		static constexpr size_t count(size_t max_elems) { return details::next_prime(max_elems * 2); }
+		static size_t index(size_t hash, size_t count) { return size_t(details::mul_high(uint64_t(hash) * 0x9E3779B97F4A7C15ULL, count)); }
+	};
+
+	//	Power of 2 count (up to 2x more buckets than the prime ones), Fibonacci hashing: top bits of hash * golden ratio.
+	//	Multiplication moves entropy only upwards - keys differing just in the high bits of the hash collide,
+	//	pair with a mixing hasher (IntegerMixHash, WyHash) for such keys.
+	struct PowerOfTwo
+	{
+		static constexpr uint32_t Id = 2;
+
+		static constexpr size_t count(size_t max_elems) { return std::bit_ceil(max_elems * 2); }
+		static size_t index(size_t hash, size_t count) { return size_t((uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> (64 - std::countr_zero(count))); }
+	};
+
+	//	Backoffs. Each provides State, a per operation backoff (pause() between attempts, wait() for the node version
+	//	seen odd to change), and notify() called by writers once node version is even again.
+
+	//	Pause growing by 10 more _mm_pause every attempt, never yields.
+	struct LinearBackoff
+	{
+		class State
+		{
+		public:
+			void pause()
+			{
+				for (int i = 0; i < wait_duration; ++i)
+					_mm_pause();
+				wait_duration += 10;
+			}
+
+			void wait(const std::atomic<size_t>&, size_t) { pause(); }
+
+		private:
+			int wait_duration = 10;
+		};
+
+		static void notify(std::atomic<size_t>&) {}
+	};
+
+	//	Pause doubling every attempt up to MaxPauses.
+	template<int MinPauses = 4, int MaxPauses = 1024>
+	struct ExponentialBackoff
+	{
+		class State
+		{
+		public:
+			void pause()
+			{
+				for (int i = 0; i < wait_duration; ++i)
+					_mm_pause();
+				wait_duration = std::min(wait_duration * 2, MaxPauses);
+			}
+
+			void wait(const std::atomic<size_t>&, size_t) { pause(); }
+
+		private:
+			int wait_duration = MinPauses;
+		};
+
+		static void notify(std::atomic<size_t>&) {}
+	};
+
+	//	Exponential pause for SpinRounds attempts, then gives the core away - for oversubscribed machines,
+	//	where the writer might be preempted in the middle of the change.
+	template<int SpinRounds = 10>
+	struct SpinThenYield
+	{
+		class State
+		{
+		public:
+			void pause()
+			{
+				if (rounds++ < SpinRounds)
+					spin.pause();
+				else
+					std::this_thread::yield();
+			}
+
+			void wait(const std::atomic<size_t>&, size_t) { pause(); }
+
+		private:
+			typename ExponentialBackoff<>::State spin;
+			int rounds = 0;
+		};
+
+		static void notify(std::atomic<size_t>&) {}
+	};
+
+	//	Same as SpinThenYield, but the one waiting for a node being changed blocks on its version (std::atomic::wait, futex on Linux)
+	//	and writers wake it up. Writers pay for notify on every change.
+	//	Waits are process local - not suitable for maps in shared memory read from other processes.
+	template<int SpinRounds = 10>
+	struct WaitOnVersion
+	{
+		class State
+		{
+		public:
+			void pause() { yielding.pause(); }
+
+			void wait(const std::atomic<size_t>& version, size_t odd_version)
+			{
+				if (rounds++ < SpinRounds)
+					yielding.pause();
+				else
+					version.wait(odd_version, std::memory_order_acquire);
+			}
+
+		private:
+			typename SpinThenYield<SpinRounds>::State yielding;
+			int rounds = 0;
+		};
+
+		static void notify(std::atomic<size_t>& version) { version.notify_all(); }
+	};
+
+	//	Stats. Each provides Counters living inside of the map, fed by the map operations, and their snapshot().
+
+	//	Nothing is counted, stats() returns zeroes.
+	struct NoStats
+	{
+		struct Counters
+		{
+			void contended(size_t, size_t) {}
+			void chain_length(size_t) {}
+			void overflow() {}
+			void evicted() {}
+			HashMapStats snapshot() const { return {}; }
+		};
+	};
+
+	//	Relaxed atomic counters. Operations touch them only when they had to retry, or when a new node is inserted.
+	struct CountingStats
+	{
+		struct Counters
+		{
+			void contended(size_t retries_num, size_t restarts_num)
+			{
+				retries.fetch_add(retries_num, std::memory_order_relaxed);
+				restarts.fetch_add(restarts_num, std::memory_order_relaxed);
+			}
+
+			void chain_length(size_t length)
+			{
+				size_t max_length = max_chain_length.load(std::memory_order_relaxed);
+				while (length > max_length && !max_chain_length.compare_exchange_weak(max_length, length, std::memory_order_relaxed));
+			}
+
+			void overflow() { overflows.fetch_add(1, std::memory_order_relaxed); }
+			void evicted() { evictions.fetch_add(1, std::memory_order_relaxed); }
+
+			HashMapStats snapshot() const
+			{
+				return { retries.load(std::memory_order_relaxed), restarts.load(std::memory_order_relaxed),
+					max_chain_length.load(std::memory_order_relaxed), overflows.load(std::memory_order_relaxed),
+					evictions.load(std::memory_order_relaxed) };
+			}
+
+			//	own cache line, away from the nodes and buckets readers go through
+			alignas(64) std::atomic<size_t> retries = 0;
+			std::atomic<size_t> restarts = 0;
+			std::atomic<size_t> max_chain_length = 0;
+			std::atomic<size_t> overflows = 0;
+			std::atomic<size_t> evictions = 0;
+		};
+	};
+
+	//	Reclamation of removed nodes. Each provides Domain<NodesNum> living inside of the map: pin() for readers,
+	//	retire()/reclaim() for the writer.
+
+	//	Removed node goes back to the allocator immediately. Reader standing on it might find it reused for another bucket,
+	//	it detects that with `part_of_bucket` and restarts from the root.
+	struct ImmediateReuse
+	{
+		static constexpr bool Deferred = false;
+
+		template<size_t NodesNum>
+		struct Domain
+		{
+			explicit Domain(size_t = NodesNum) {}
+
+			struct Guard {};
+			Guard pin() { return {}; }
+		};
 	};
 
-	auto pause_closure() {
-		return [wait_duration = 10]() mutable {
-			//	pause a bit
-			for (int i = 0; i < wait_duration; ++i)
-				_mm_pause();
+	//	Epoch based reclamation. Reader announces global epoch in a slot for the duration of the operation, writer bumps
+	//	the epoch on every removal and reuses a removed node only once every announced epoch is newer than its removal.
+	//	Removed node keeps its links, so reader standing on it just continues along the chain - no derailing, no restarts.
+	//
+	//	Slots are claimed per operation (CAS, starting from the slot thread used last time), state is all inside of the map,
+	//	so readers from other processes are fine. Costs readers a CAS and a store per operation.
+	//	Removed nodes count against the capacity until reclaimed. Once the map is full, writer waits for pinned readers -
+	//	a reader process dying in the middle of read blocks reclamation of everything removed after.
+	//	MaxReaders is the number of slots, not a limit: readers finding all of them taken count themselves in a shared
+	//	overflow counter instead (a single contended cache line). Nothing removed while the counter is non zero is reused
+	//	until writer sees it drop to zero - steady stream of overflowing readers holds reclamation back, size the slots up.
+	template<size_t MaxReaders = 64, size_t ReclaimBatch = 64>
+	struct EpochReclamation
+	{
+		static constexpr bool Deferred = true;
+
+		template<size_t NodesNum>
+		class Domain
+		{
+			struct alignas(64) ReaderSlot
+			{
+				std::atomic<uint64_t> epoch = 0;	//	0 - slot is free
+			};
+
+		public:
+			explicit Domain(size_t nodes_num = NodesNum) : retired(nodes_num), retired_at(nodes_num) {}
+
+			class Guard
+			{
+			public:
+				//	`overflow` - guard of a reader counted in the overflow counter, `slot` is the counter then
+				Guard(std::atomic<uint64_t>& slot, bool overflow) : slot(slot), overflow(overflow) {}
+				~Guard()
+				{
+					if (overflow)
+						slot.fetch_sub(1, std::memory_order_release);
+					else
+						slot.store(0, std::memory_order_release);
+				}
+
+				Guard(const Guard&) = delete;
+				Guard& operator=(const Guard&) = delete;
 
-			wait_duration += 10;
+			private:
+				std::atomic<uint64_t>& slot;
+				const bool overflow;
 			};
+
+			//	Reader. Nodes reachable from the buckets are not reused until the guard is gone.
+			//	Lock free: one pass over the slots at most, then the overflow counter.
+			Guard pin()
+			{
+				static thread_local size_t slot_hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+				for (size_t attempt = 0; attempt < MaxReaders; ++attempt)
+				{
+					const size_t slot_idx = (slot_hint + attempt) % MaxReaders;
+					std::atomic<uint64_t>& slot = slots[slot_idx].epoch;
+					uint64_t epoch = global_epoch.load(std::memory_order_seq_cst);
+					uint64_t free_slot = 0;
+					if (slot.load(std::memory_order_relaxed) != 0 || !slot.compare_exchange_strong(free_slot, epoch, std::memory_order_seq_cst))
+						continue;
+
+					//	Writer might have bumped the epoch and scanned slots before seeing ours. Announced epoch is valid only
+					//	if it's still current after announcing - then any later scan sees it, otherwise we see what was removed.
+					for (uint64_t current; (current = global_epoch.load(std::memory_order_seq_cst)) != epoch; epoch = current)
+						slot.store(current, std::memory_order_seq_cst);
+
+					slot_hint = slot_idx;
+					return Guard(slot, false);
+				}
+
+				//	All slots are taken. Same as for a slot, the epoch load after the increment pairs with the writer's
+				//	epoch bump: either writer's next scan sees the counter, or we see the node unlinked.
+				overflow_readers.fetch_add(1, std::memory_order_seq_cst);
+				global_epoch.load(std::memory_order_seq_cst);
+				return Guard(overflow_readers, true);
+			}
+
+			//	Writer. `node_idx` was unlinked, `free(node_idx)` is called once no reader can be standing on it.
+			template<typename F>
+			void retire(size_t node_idx, F&& free)
+			{
+				const uint64_t epoch = global_epoch.load(std::memory_order_relaxed);
+				retired_at[node_idx] = epoch;
+				retired[(retired_head + retired_num++) % retired.size()] = node_idx;
+				global_epoch.store(epoch + 1, std::memory_order_seq_cst);
+
+				if (retired_num >= ReclaimBatch)
+					reclaim(free, false);
+			}
+
+			//	Writer. Frees every retired node no reader can be standing on, oldest first. With `wait` - waits until
+			//	at least one is freed. Returns false if nothing was freed.
+			template<typename F>
+			bool reclaim(F&& free, bool wait)
+			{
+				bool freed = false;
+				uint64_t oldest = oldest_pinned();
+				while (retired_num > 0)
+				{
+					const size_t node_idx = retired[retired_head];
+					if (retired_at[node_idx] >= oldest)
+					{
+						if (!wait || freed)
+							break;
+
+						_mm_pause();
+						oldest = oldest_pinned();
+						continue;
+					}
+
+					free(node_idx);
+					freed = true;
+					retired_head = (retired_head + 1) % retired.size();
+					--retired_num;
+				}
+				return freed;
+			}
+
+		private:
+			uint64_t oldest_pinned()
+			{
+				//	Overflowing readers announce no epoch. Counter seen zero means none of them is in since everything
+				//	retired so far was retired, otherwise they might stand on anything retired since it was seen zero last.
+				if (overflow_readers.load(std::memory_order_seq_cst) == 0)
+					overflow_clear_epoch = global_epoch.load(std::memory_order_relaxed);
+				uint64_t oldest = overflow_clear_epoch;
+
+				for (const ReaderSlot& slot : slots)
+				{
+					const uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+					if (epoch != 0)
+						oldest = std::min(oldest, epoch);
+				}
+				return oldest;
+			}
+
+			alignas(64) std::atomic<uint64_t> global_epoch = 1;
+			std::array<ReaderSlot, MaxReaders> slots;
+			alignas(64) std::atomic<uint64_t> overflow_readers = 0;
+			//	writer only, FIFO of removed nodes - epochs are increasing along it
+			details::FixedArray<size_t, NodesNum> retired;
+			details::FixedArray<uint64_t, NodesNum> retired_at;
+			size_t retired_head = 0;
+			size_t retired_num = 0;
+			uint64_t overflow_clear_epoch = 1;	//	global epoch when the overflow counter was last seen zero
+		};
+	};
+
+	//	Sorted indexes. Each provides Levels (0 - no index) and Links<NodesNum> living inside of the map, holding the index
+	//	links of every node.
+
+	//	No index, visit_range/visit_sorted are not available.
+	struct NoIndex
+	{
+		static constexpr size_t Levels = 0;
+		using Less = std::less<>;
+
+		template<size_t NodesNum>
+		struct Links
+		{
+			explicit Links(size_t = NodesNum) {}
+		};
+	};
+
+	//	Skip list over the nodes, kept in key order (Less) by the single writer, read lock free. Every node is linked into
+	//	the bottom list and, picked by its key hash, into a quarter as many lists above as the one below, up to Levels lists.
+	//	Takes Levels links per node - size Levels for log4 of the capacity, the default fits 16M keys.
+	template<size_t IndexLevels = 12, typename IndexLess = std::less<>>
+	struct SkipListIndex
+	{
+		static constexpr size_t Levels = IndexLevels;
+		using Less = IndexLess;
+		static_assert(Levels > 0);
+
+		template<size_t NodesNum>
+		struct Links
+		{
+			//	index of the list heads, in place of a node index
+			static constexpr size_t Head = std::numeric_limits<size_t>::max() - 1;
+
+			explicit Links(size_t nodes_num = NodesNum) : towers(nodes_num)
+			{
+				for (auto& link : head)
+					link.store(std::numeric_limits<size_t>::max(), std::memory_order_relaxed);
+			}
+
+			std::atomic<size_t>& at(size_t node_idx, size_t level) { return node_idx == Head ? head[level] : towers[node_idx][level]; }
+
+		private:
+			std::array<std::atomic<size_t>, Levels> head;
+			details::FixedArray<std::array<std::atomic<size_t>, Levels>, NodesNum> towers;
+		};
+	};
+
+	//	Eviction. Each provides Domain<NodesNum> living inside of the map: touch() for readers of a key, inserted()/updated()
+	//	for the writer of it, and the CLOCK hand (advance(), second_chance()) and time to live (now(), expired()) the writer
+	//	picks the keys to evict with.
+
+	//	Nothing is evicted, store into the full map throws.
+	struct NoEviction
+	{
+		static constexpr bool Enabled = false;
+		static constexpr bool Expiring = false;
+
+		template<size_t NodesNum>
+		struct Domain
+		{
+			explicit Domain(size_t = NodesNum) {}
+
+			void touch(size_t) {}
+			void inserted(size_t) {}
+			void updated(size_t) {}
+			static int64_t now() { return 0; }
+			bool expired(size_t, int64_t) const { return false; }
+		};
+	};
+
+	//	CLOCK (second chance) approximation of LRU. Reader of a key sets its reference bit - a relaxed store, and only if the
+	//	bit is clear, so hot keys don't keep dirtying the line. Once the map is full, writer's hand goes around the nodes
+	//	clearing the bits, and evicts the first key read by nobody since the hand passed it the last time. Scans (visit)
+	//	don't count as reads. New key starts referenced, so it survives at least one turn of the hand.
+	//
+	//	With TimeToLiveMs, a key expires that long after its last store: readers see it absent from then on, the hand
+	//	evicts it regardless of its bit, evict_expired() removes all of the expired keys at once. Costs a clock read per read.
+	//	State is all inside of the map (steady clock is system wide), so readers from other processes are fine.
+	//	TimeSource is a clock with static now() (std::chrono style), other than steady_clock mostly for tests.
+	template<uint64_t TimeToLiveMs = 0, typename TimeSource = std::chrono::steady_clock>
+	struct ClockEviction
+	{
+		static constexpr bool Enabled = true;
+		static constexpr bool Expiring = TimeToLiveMs != 0;
+
+		template<size_t NodesNum>
+		class Domain
+		{
+			using Clock = TimeSource;
+			static constexpr int64_t TimeToLive = std::chrono::duration_cast<typename Clock::duration>(std::chrono::milliseconds(TimeToLiveMs)).count();
+			static constexpr size_t StampsNum = Expiring ? NodesNum : 0;
+
+		public:
+			explicit Domain(size_t nodes_num = NodesNum) : referenced(nodes_num), stored_at(Expiring ? nodes_num : 0) {}
+
+			//	Reader, the key of the node was read
+			void touch(size_t node_idx)
+			{
+				if (referenced[node_idx].load(std::memory_order_relaxed) == 0)
+					referenced[node_idx].store(1, std::memory_order_relaxed);
+			}
+
+			//	Writer, before the node is published
+			void inserted(size_t node_idx)
+			{
+				referenced[node_idx].store(1, std::memory_order_relaxed);
+				updated(node_idx);
+			}
+
+			//	Writer, before the value is written - time to live starts over
+			void updated(size_t node_idx)
+			{
+				if constexpr (Expiring)
+					stored_at[node_idx].store(now(), std::memory_order_relaxed);
+			}
+
+			static int64_t now()
+			{
+				if constexpr (Expiring)
+					return Clock::now().time_since_epoch().count();
+				else
+					return 0;
+			}
+
+			bool expired(size_t node_idx, int64_t now) const
+			{
+				if constexpr (Expiring)
+					return now - stored_at[node_idx].load(std::memory_order_relaxed) >= TimeToLive;
+				else
+					return false;
+			}
+
+			//	Writer. Node under the hand, hand moves on to the next one.
+			size_t advance(size_t nodes_num)
+			{
+				const size_t node_idx = hand;
+				hand = (hand + 1) % nodes_num;
+				return node_idx;
+			}
+
+			//	Writer. Clears the reference bit, true if it was set - the key is spared this turn.
+			bool second_chance(size_t node_idx)
+			{
+				if (referenced[node_idx].load(std::memory_order_relaxed) == 0)
+					return false;
+
+				referenced[node_idx].store(0, std::memory_order_relaxed);
+				return true;
+			}
+
+		private:
+			details::FixedArray<std::atomic<uint8_t>, NodesNum> referenced;
+			details::FixedArray<std::atomic<int64_t>, StampsNum> stored_at;	//	steady clock ticks of the last store
+			size_t hand = 0;
+		};
+	};
+
+	//	Schedule points. Steps of the seqlock protocol, where another thread's step makes a difference. Each policy provides
+	//	static point(SchedulePoint), called by the thread about to make the step.
+	enum class SchedulePoint : uint8_t
+	{
+		BucketLoad,		//	about to load the root of a bucket
+		VersionLoad,	//	about to load a node version, before or after reading the node
+		NodeRead,		//	about to read the node fields, between its version loads
+		NodeWrite,		//	writer, inside of the write section of a node (odd version), or about to lock/unlock it
+		BucketStore,	//	writer, about to change the root of a bucket
+		Retry,			//	about to pause and retry - the node is being changed, or reader derailed
+		ReaderEnter,	//	reader of LockFreeGrowableHashMap, between picking its readers group and joining it
+	};
+
+	//	No points, compiles away.
+	struct NoSchedulePoints
+	{
+		static void point(SchedulePoint) {}
+	};
+
+	//	Hands every point over to the callback the calling thread attached, threads without one just go on.
+	//	For tests only: it costs a thread local lookup at every step.
+	struct SchedulePointHook
+	{
+		using Callback = void (*)(void* context, SchedulePoint point);
+
+		//	points of the calling thread go to `callback(context, point)` from now on, nullptr detaches
+		static void attach(Callback callback, void* context) { hook() = Hook{ callback, context }; }
+
+		static void point(SchedulePoint point)
+		{
+			const Hook& current = hook();
+			if (current.callback)
+				current.callback(current.context, point);
+		}
+
+	private:
+		struct Hook
+		{
+			Callback callback = nullptr;
+			void* context = nullptr;
+		};
+
+		static Hook& hook()
+		{
+			static thread_local Hook current;
+			return current;
+		}
+	};
+
+	//	Defaults for the LockFreeFixedSizeHashMap Traits parameter. Derive and override to tune:
+	//		struct MyTraits : hashmap_policy::DefaultTraits { using NodeLayout = hashmap_policy::AlignedNodes; };
+	struct DefaultTraits
+	{
+		using NodeLayout = PackedNodes;
+		using Writers = SingleWriter;
+
+		template<typename K>
+		using Hash = std::hash<K>;
+		using KeyEqual = std::equal_to<>;
+		using Buckets = PrimeModulo;
+		using Backoff = LinearBackoff;
+		using Stats = NoStats;
+		using Reclamation = ImmediateReuse;
+		using Index = NoIndex;
+		using Eviction = NoEviction;
+		using Schedule = NoSchedulePoints;
+	};
+}
+
+
+template<typename K, typename V, size_t MaxElems, typename Traits = hashmap_policy::DefaultTraits>
+	requires details::TriviallyCopyablePair<K, V>
+class LockFreeFixedSizeHashMap
+{
+	static constexpr size_t EmptyBucketTag = std::numeric_limits<size_t>::max();
+
+	using NodeLayout = typename Traits::NodeLayout;
+	using Writers = typename Traits::Writers;
+	using Hash = typename Traits::template Hash<K>;
+	using KeyEqual = typename Traits::KeyEqual;
+	using Buckets = typename Traits::Buckets;
+	using Backoff = typename Traits::Backoff;
+	using StatsCounters = typename Traits::Stats::Counters;
+	using Reclamation = typename Traits::Reclamation;
+	static_assert(!(Reclamation::Deferred && Writers::Concurrent), "Deferred reclamation supports single writer only");
+	using Index = typename Traits::Index;
+	static_assert(!(Index::Levels != 0 && Writers::Concurrent), "Sorted index supports single writer only");
+	using Eviction = typename Traits::Eviction;
+	static_assert(!(Eviction::Enabled && Writers::Concurrent), "Eviction supports single writer only");
+	using Schedule = typename Traits::Schedule;
+	using SchedulePoint = hashmap_policy::SchedulePoint;
+
+	//	set in `part_of_bucket` of a node removed but not reclaimed yet, node still links to the rest of its chain
+	static constexpr size_t RetiredBucketTag = size_t(1) << (std::numeric_limits<size_t>::digits - 1);
+	using NodeRef = details::NodeRef<K, V>;
+
+	static constexpr bool DynamicExtent = MaxElems == std::dynamic_extent;
+
+	//	migrates nodes between its tables directly (writer side)
+	template<typename, typename, typename>
+	friend class LockFreeGrowableHashMap;
+	static constexpr size_t BucketsNum = DynamicExtent ? std::dynamic_extent : Buckets::count(MaxElems);
+
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using hasher = Hash;
+
+	LockFreeFixedSizeHashMap() requires (!DynamicExtent)
+	{
+		std::fill(buckets.begin(), buckets.end(), EmptyBucketTag);
+	}
+
+	//	Capacity chosen at runtime, for MaxElems = std::dynamic_extent. Storage is heap allocated then,
+	//	such map can't be placed into shared memory.
+	explicit LockFreeFixedSizeHashMap(size_t max_elems) requires DynamicExtent
+		: buckets(Buckets::count(max_elems)), nodes(max_elems), node_allocator(max_elems), reclamation(max_elems), index_links(max_elems), eviction(max_elems)
+	{
+		std::fill(buckets.begin(), buckets.end(), EmptyBucketTag);
+	}
+
+	size_t capacity() const
+	{
+		return node_allocator.nodes_max();
+	}
+
+	//	Number of bytes required to place the map with its header into a memory region
+	static constexpr size_t shared_memory_size() requires (!DynamicExtent)
+	{
+		return shared_memory_size_of<LockFreeFixedSizeHashMap>();
+	}
+
+	//	Writer side. Constructs the map inside of `memory`, overwriting whatever was there.
+	//	Memory has to stay mapped for as long as map is used, map is never destroyed (it's trivial).
+	static LockFreeFixedSizeHashMap* create_in(void* memory, size_t size) requires (!DynamicExtent)
+	{
+		return create_as<LockFreeFixedSizeHashMap>(memory, size);
+	}
+
+	//	Reader side. Validates the header left by create_in and returns the map placed after it.
+	//	Throws if the region was created for a different map type or the writer hasn't finished construction yet.
+	static LockFreeFixedSizeHashMap* attach_to(void* memory, size_t size) requires (!DynamicExtent)
+	{
+		return attach_as<LockFreeFixedSizeHashMap>(memory, size);
+	}
+
+	//	Returns true if the key was inserted, false if its value was overwritten
+	bool store(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	{
+		auto assign = [&](V& node_value) { node_value = std::forward<decltype(value)>(value); };
+		return write<true>(key, assign, assign);
+	}
+
+	//	Stores only if the key is not there yet, value of the existing key is left untouched (and its readers undisturbed).
+	//	Returns true if the key was inserted.
+	bool store_if_absent(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	{
+		return write<false>(key, [](V&) {}, [&](V& node_value) { node_value = std::forward<decltype(value)>(value); });
+	}
+
+	//	Stores many pairs at once, same outcome as store() of each in order (duplicate keys keep the last value). Returns number
+	//	of keys inserted. Pairs are taken in windows, bucket roots and first nodes of the windows ahead are prefetched (as in
+	//	read_batch). Pairs of a window are grouped by bucket - every group walks the chain once, and its new nodes are chained
+	//	in front and published by a single root store. Nodes no reader can reach yet are written without the seqlock,
+	//	the rest take plain stores of the version instead of read-modify-writes (single writer owns the versions).
+	//	Throws on overfill, some of the pairs stay stored then. With MultiWriter, or with eviction (which could take away
+	//	the nodes of a group being stored), it's a loop of store().
+	size_t store_batch(std::span<const std::pair<K, V>> items)
+	{
+		size_t inserted = 0;
+		if constexpr (Writers::Concurrent || Eviction::Enabled)
+		{
+			for (const auto& [key, value] : items)
+				inserted += store(key, V(value)) ? 1 : 0;
+		}
+		else
+		{
+			Mutation mutation(*this);
+
+			//	Software pipeline over windows: while window w is stored, first nodes of the chains of window w + 1 and
+			//	bucket roots of window w + 2 are being prefetched
+			const size_t windows_num = (items.size() + BatchWindowSize - 1) / BatchWindowSize;
+			auto window_of = [&](size_t window_idx) {
+				const size_t window_start = window_idx * BatchWindowSize;
+				return items.subspan(window_start, std::min(BatchWindowSize, items.size() - window_start));
+			};
+			size_t window_buckets[3][BatchWindowSize];
+			auto prefetch_buckets = [&](size_t window_idx) {
+				const size_t window_start = window_idx * BatchWindowSize;
+				if (window_start >= items.size())
+					return;
+				const size_t window_end = std::min(window_start + BatchWindowSize, items.size());
+				size_t* bucket_idxs = window_buckets[window_idx % 3];
+				for (size_t i = window_start; i < window_end; ++i)
+				{
+					const size_t bucket_idx = bucket_of(items[i].first);
+					bucket_idxs[i - window_start] = bucket_idx;
+					_mm_prefetch(reinterpret_cast<const char*>(&buckets[bucket_idx]), _MM_HINT_T0);
+				}
+			};
+			auto prefetch_roots = [&](size_t window_idx) {
+				if (window_idx >= windows_num)
+					return;
+				const size_t* bucket_idxs = window_buckets[window_idx % 3];
+				for (size_t i = 0; i < window_of(window_idx).size(); ++i)
+				{
+					//	only a hint, the root is reloaded once the window is stored
+					const size_t root_node_idx = buckets[bucket_idxs[i]].load(std::memory_order_relaxed);
+					if (root_node_idx != EmptyBucketTag)
+						_mm_prefetch(static_cast<const char*>(nodes.hot_address(root_node_idx)), _MM_HINT_T0);
+				}
+			};
+
+			prefetch_buckets(0);
+			prefetch_buckets(1);
+			prefetch_roots(0);
+			for (size_t window_idx = 0; window_idx < windows_num; ++window_idx)
+			{
+				prefetch_buckets(window_idx + 2);
+				prefetch_roots(window_idx + 1);
+
+				const auto window = window_of(window_idx);
+				const size_t* bucket_idxs = window_buckets[window_idx % 3];
+
+				//	groups keep the order of their pairs, so duplicate keys end up with the last value.
+				//	Order between buckets doesn't matter.
+				bool grouped[BatchWindowSize] = {};
+				size_t group[BatchWindowSize];
+				for (size_t i = 0; i < window.size(); ++i)
+				{
+					if (grouped[i])
+						continue;
+
+					size_t group_size = 0;
+					for (size_t j = i; j < window.size(); ++j)
+						if (bucket_idxs[j] == bucket_idxs[i])
+						{
+							grouped[j] = true;
+							group[group_size++] = j;
+						}
+
+					inserted += store_group(bucket_idxs[i], window, std::span<const size_t>(group, group_size));
+				}
+			}
+		}
+		return inserted;
+	}
+
+	//	Read-modify-write in a single chain walk: `update(V&)` runs on the value in place, inside of the node's write section,
+	//	so readers never see it half updated. Absent key is inserted with value initialized V{} first. Returns true if inserted.
+	//	With MultiWriter other writers are locked out of the node meanwhile, so concurrent updates never get lost.
+	//	`update` might also run on a prepared node thrown away because another writer inserted the key first.
+	template<typename F>
+	bool upsert(const K& key, F&& update)
+	{
+		return write<true>(key, update, [&](V& node_value) { node_value = V{}; update(node_value); });
+	}
+
+	//	`func(const V* value)` gets the current value (nullptr if the key is absent) and returns the new one,
+	//	or std::nullopt to remove the key (or to leave it absent). Returns what the key maps to afterwards.
+	//	Single writer only - removal would need the preceding node locked before the value is even seen.
+	template<typename F>
+	std::optional<V> compute(const K& key, F&& func) requires (!Writers::Concurrent)
+	{
+		const size_t bucket_idx = bucket_of(key);
+		Mutation mutation(*this, bucket_idx);
+
+		const WriterPosition pos = find_for_write(bucket_idx, key);
+		if (pos.node_idx == EmptyBucketTag)
+		{
+			std::optional<V> result = func(static_cast<const V*>(nullptr));
+			if (result)
+				insert_node(bucket_idx, key, [&](V& node_value) { node_value = *result; }, pos.chain_length);
+			return result;
+		}
+
+		//	single writer, nobody else changes the value - no need to guard reading it
+		NodeRef node = nodes[pos.node_idx];
+		std::optional<V> result = func(static_cast<const V*>(&node.value));
+		if (result)
+		{
+			eviction.updated(pos.node_idx);
+			update_node(node, bucket_idx, [&](V& node_value) { node_value = *result; });
+		}
+		else
+			unlink_node(bucket_idx, pos);
+		return result;
+	}
+
+	template<typename CompatibleK>
+	std::optional<V> read(const CompatibleK& key)
+	{
+		return read_with(key, [](const V& value) { return value; });
+	}
+
+	//	Reads in place: `project(const V&)` is called on the value inside of the node and only its result is returned,
+	//	saves copying the whole value when a part of it is needed.
+	//	Projection runs speculatively - it may see a value being overwritten, then its result is thrown away and it's called again.
+	//	So it has to be cheap, have no side effects and must not trust the data it sees (no following pointers/sizes from the value).
+	template<typename CompatibleK, typename F>
+	auto read_with(const CompatibleK& key, F&& project)
+	{
+		return read_from_bucket(bucket_of(key), key, project);
+	}
+
+	//	State of a key as seen by read_versioned, for wait_for_change. Changes with every write to the key, and might also
+	//	change when a neighbouring key of the bucket is removed. Default constructed - key is absent.
+	struct KeyVersion
+	{
+		size_t node_idx = EmptyBucketTag;
+		size_t node_version = 0;
+
+		bool operator==(const KeyVersion&) const = default;
+	};
+
+	struct VersionedValue
+	{
+		std::optional<V> value;
+		KeyVersion version;
+	};
+
+	//	Same as read(), along with the version of the key
+	template<typename CompatibleK>
+	VersionedValue read_versioned(const CompatibleK& key)
+	{
+		VersionedValue result;
+		result.value = read_from_bucket(bucket_of(key), key, [](const V& value) { return value; }, &result.version);
+		return result;
+	}
+
+	//	Blocks until `key` is in the map and returns its value, or std::nullopt once `timeout` is over.
+	//	Waiting reader sleeps in the kernel and is woken up only by writes to its bucket (or to buckets sharing its wait stripe).
+	template<typename CompatibleK, typename Rep, typename Period>
+	std::optional<V> wait_for(const CompatibleK& key, std::chrono::duration<Rep, Period> timeout)
+	{
+		const size_t bucket_idx = bucket_of(key);
+		return waiters.wait(bucket_idx, deadline_after(timeout), [&] { return read_from_bucket(bucket_idx, key, [](const V& value) { return value; }); });
+	}
+
+	//	Blocks until version of `key` differs from `last_version` (taken by read_versioned or a previous wait_for_change),
+	//	returns the new value (std::nullopt value - key is gone) and version. Returns std::nullopt once `timeout` is over.
+	template<typename CompatibleK, typename Rep, typename Period>
+	std::optional<VersionedValue> wait_for_change(const CompatibleK& key, const KeyVersion& last_version, std::chrono::duration<Rep, Period> timeout)
+	{
+		const size_t bucket_idx = bucket_of(key);
+		return waiters.wait(bucket_idx, deadline_after(timeout), [&] {
+			VersionedValue current;
+			current.value = read_from_bucket(bucket_idx, key, [](const V& value) { return value; }, &current.version);
+			return current.version != last_version ? std::optional<VersionedValue>(current) : std::nullopt;
+		});
+	}
+
+	//	Reads many keys at once, results[i] receives value of keys[i]. Same guarantees as read() for every key.
+	//	Keys are processed in groups: all keys of a group are hashed and their bucket roots prefetched, then the first
+	//	nodes of the chains are prefetched, and only then lookups run. Cache misses of independent keys overlap
+	//	instead of being paid one after another.
+	void read_batch(std::span<const K> keys, std::span<std::optional<V>> results)
+	{
+		assert(keys.size() == results.size());
+		constexpr size_t GroupSize = 16;
+
+		size_t bucket_idxs[GroupSize];
+		for (size_t group_start = 0; group_start < keys.size(); group_start += GroupSize)
+		{
+			const size_t group_size = std::min(GroupSize, keys.size() - group_start);
+			const K* group_keys = &keys[group_start];
+
+			for (size_t i = 0; i < group_size; ++i)
+			{
+				bucket_idxs[i] = bucket_of(group_keys[i]);
+				_mm_prefetch(reinterpret_cast<const char*>(&buckets[bucket_idxs[i]]), _MM_HINT_T0);
+			}
+
+			for (size_t i = 0; i < group_size; ++i)
+			{
+				//	only a hint, read_from_bucket reloads the root properly
+				const size_t root_node_idx = buckets[bucket_idxs[i]].load(std::memory_order_relaxed);
+				if (root_node_idx != EmptyBucketTag)
+					_mm_prefetch(static_cast<const char*>(nodes.hot_address(root_node_idx)), _MM_HINT_T0);
+			}
+
+			for (size_t i = 0; i < group_size; ++i)
+				results[group_start + i] = read_from_bucket(bucket_idxs[i], group_keys[i], [](const V& value) { return value; });
+		}
+	}
+
+	template<typename CompatibleK>
+	bool remove(const CompatibleK& key)
+	{
+		return remove_if(key, [](const V&) { return true; });
+	}
+
+	//	Removes the key only if `pred(const V&)` holds for its value, returns true if removed
+	template<typename CompatibleK, typename P>
+	bool remove_if(const CompatibleK& key, P&& pred)
+	{
+		const size_t bucket_idx = bucket_of(key);
+		Mutation mutation(*this, bucket_idx);
+		if constexpr (Writers::Concurrent)
+			return remove_concurrent(bucket_idx, key, pred);
+		else
+		{
+			const WriterPosition pos = find_for_write(bucket_idx, key);
+			if (pos.node_idx == EmptyBucketTag || !pred(std::as_const(nodes[pos.node_idx].value)))
+				return false;
+
+			unlink_node(bucket_idx, pos);
+			return true;
+		}
+	}
+
+	//	Removes every key past its time to live (Traits::Eviction), returns how many. Expired keys already read as absent,
+	//	this gives their nodes back ahead of time - otherwise the store into the full map evicts them, one at a time.
+	size_t evict_expired() requires (Eviction::Expiring)
+	{
+		Mutation mutation(*this);
+		const int64_t now = eviction.now();
+		size_t evicted = 0;
+		for (size_t node_idx = 0; node_idx < capacity(); ++node_idx)
+		{
+			if ((nodes[node_idx].part_of_bucket & RetiredBucketTag) == 0 && eviction.expired(node_idx, now))
+			{
+				evict_node(node_idx);
+				++evicted;
+			}
+		}
+		return evicted;
+	}
+
+	//	Writer side, fills a freshly constructed map with [key, value] pairs of `range` far cheaper than storing them one by one.
+	//	Keys are counting sorted by bucket, so nodes of every bucket lie next to each other, in chain order.
+	//	Meant to run before readers attach: nodes are written without the seqlock, readers would see keys appear
+	//	bucket by bucket at best. Duplicate keys keep the last value, same as with store().
+	//	Throws if the map has been written to before, or `range` doesn't fit (map is left untouched then).
+	template<std::ranges::input_range R>
+	void bulk_load(R&& range)
+	{
+		if constexpr (!std::ranges::forward_range<R>)
+		{
+			//	single pass range, two passes are needed
+			std::vector<std::pair<K, V>> items;
+			for (auto&& [key, value] : range)
+				items.emplace_back(key, value);
+			return bulk_load(items);
+		}
+		else
+		{
+			if (mutations_started.load(std::memory_order_relaxed) != 0)
+				throw std::runtime_error("Hash map bulk load: map is not empty");
+
+			//	Sorted in two levels, so no pass scatters over the whole memory at random: items are first distributed
+			//	between partitions (contiguous ranges of buckets, few enough for their counters and write heads to stay in cache),
+			//	then every partition is counting sorted by bucket on its own, its share of nodes fits into cache.
+			const size_t buckets_per_partition = (buckets.size() + BulkLoadPartitionsMax - 1) / BulkLoadPartitionsMax;
+			const size_t partitions_num = (buckets.size() + buckets_per_partition - 1) / buckets_per_partition;
+
+			//	`partition_starts[p]` is where nodes of partition p start
+			std::vector<size_t> item_buckets;
+			if constexpr (std::ranges::sized_range<R>)
+				item_buckets.reserve(std::ranges::size(range));
+			std::vector<size_t> partition_starts(partitions_num + 1, 0);
+			for (auto&& [key, value] : range)
+			{
+				item_buckets.push_back(bucket_of(key));
+				++partition_starts[item_buckets.back() / buckets_per_partition + 1];
+			}
+			for (size_t partition_idx = 0; partition_idx < partitions_num; ++partition_idx)
+				partition_starts[partition_idx + 1] += partition_starts[partition_idx];
+
+			const size_t items_num = item_buckets.size();
+			if (items_num > capacity())
+			{
+				counters.overflow();
+				throw std::runtime_error("Hash map overflow");
+			}
+
+			Mutation mutation(*this);
+
+			//	items are copied, so the last pass reads them sequentially too
+			struct Placement
+			{
+				size_t bucket_idx;
+				K key;
+				V value;
+			};
+			auto placements = std::make_unique_for_overwrite<Placement[]>(items_num);
+			{
+				std::vector<size_t> partition_ends(partition_starts.begin(), partition_starts.end() - 1);
+				size_t item_idx = 0;
+				for (auto&& [key, value] : range)
+				{
+					const size_t bucket_idx = item_buckets[item_idx++];
+					Placement& placement = placements[partition_ends[bucket_idx / buckets_per_partition]++];
+					placement.bucket_idx = bucket_idx;
+					placement.key = key;
+					placement.value = value;
+				}
+			}
+			item_buckets = {};
+
+			//	Nodes are written sequentially, bucket after bucket, chained in order.
+			//	Duplicate key overwrites value of the node stored earlier (sort is stable, so the last one wins) and leaves a hole.
+			std::vector<size_t> holes;
+			std::vector<size_t> bucket_starts(buckets_per_partition + 1);
+			std::vector<const Placement*> sorted_placements;
+			for (size_t partition_idx = 0; partition_idx < partitions_num; ++partition_idx)
+			{
+				const size_t first_bucket_idx = partition_idx * buckets_per_partition;
+				const size_t partition_buckets_num = std::min(buckets_per_partition, buckets.size() - first_bucket_idx);
+				const std::span<const Placement> partition(&placements[partition_starts[partition_idx]], &placements[partition_starts[partition_idx + 1]]);
+
+				std::fill(bucket_starts.begin(), bucket_starts.end(), 0);
+				for (const Placement& placement : partition)
+					++bucket_starts[placement.bucket_idx - first_bucket_idx + 1];
+				for (size_t bucket_idx = 0; bucket_idx < partition_buckets_num; ++bucket_idx)
+					bucket_starts[bucket_idx + 1] += bucket_starts[bucket_idx];
+
+				sorted_placements.resize(partition.size());
+				for (const Placement& placement : partition)
+					sorted_placements[bucket_starts[placement.bucket_idx - first_bucket_idx]++] = &placement;
+				//	counting moved every start to the end of its bucket, which is the start of the next one
+				std::shift_right(bucket_starts.begin(), bucket_starts.end(), 1);
+				bucket_starts[0] = 0;
+
+				for (size_t bucket_idx = 0; bucket_idx < partition_buckets_num; ++bucket_idx)
+				{
+					size_t root_node_idx = EmptyBucketTag;
+					size_t previous_node_idx = EmptyBucketTag;
+					size_t chain_length = 0;
+					for (size_t sorted_idx = bucket_starts[bucket_idx]; sorted_idx < bucket_starts[bucket_idx + 1]; ++sorted_idx)
+					{
+						const Placement& placement = *sorted_placements[sorted_idx];
+						const size_t node_idx = partition_starts[partition_idx] + sorted_idx;
+
+						bool duplicate = false;
+						for (size_t same_bucket_idx = root_node_idx; same_bucket_idx != EmptyBucketTag && !duplicate;)
+						{
+							NodeRef same_bucket_node = nodes[same_bucket_idx];
+							duplicate = keys_equal(same_bucket_node.key, placement.key);
+							if (duplicate)
+								same_bucket_node.value = placement.value;
+							same_bucket_idx = same_bucket_node.next_node.load(std::memory_order_relaxed);
+						}
+						if (duplicate)
+						{
+							holes.push_back(node_idx);
+							continue;
+						}
+
+						NodeRef node = nodes[node_idx];
+						node.placement_new();
+						node.key = placement.key;
+						node.value = placement.value;
+						node.part_of_bucket = placement.bucket_idx;
+						eviction.inserted(node_idx);
+						if (previous_node_idx != EmptyBucketTag)
+							nodes[previous_node_idx].next_node.store(node_idx, std::memory_order_relaxed);
+						else
+							root_node_idx = node_idx;
+						previous_node_idx = node_idx;
+						++chain_length;
+					}
+
+					if (root_node_idx != EmptyBucketTag)
+					{
+						buckets[first_bucket_idx + bucket_idx].store(root_node_idx, std::memory_order_release);
+						counters.chain_length(chain_length);
+					}
+				}
+			}
+
+			node_allocator.take_first(items_num);
+			for (size_t node_idx : holes)
+				node_allocator.free(node_idx);
+
+			index_build();
+		}
+	}
+
+	//	Point in time copy of the map, see snapshot()
+	struct Snapshot
+	{
+		size_t generation = 0;	//	write counter of the map at the moment of the copy, grows with every store/remove
+		std::vector<std::pair<K, V>> items;
+	};
+
+	//	Copy of the map as it was at a single moment, unlike visit() - no key is missed or seen twice.
+	//	Scans optimistically: copy is consistent if no write was in flight or started during the scan, otherwise it's retried.
+	//	Writers never wait for snapshots, so under a steady stream of writes every scan might be spoiled - nullopt is returned
+	//	once `max_attempts` are. Takes a pause (Traits::Backoff) between attempts, giving writes in flight a chance to finish.
+	std::optional<Snapshot> snapshot(size_t max_attempts = SnapshotAttempts)
+	{
+		Snapshot result;
+		Contention contention(counters);
+		for (size_t attempt = 0; attempt < max_attempts; ++attempt)
+		{
+			if (try_snapshot(result))
+				return result;
+			contention.retry();
+		}
+		return std::nullopt;
+	}
+
+	//	Contention counters, all zeroes unless Traits::Stats counts them
+	HashMapStats stats() const
+	{
+		return counters.snapshot();
+	}
+
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit(F func)
+	{
+		visit_with([](const K& key, const V& value) { return std::make_pair(key, value); }, [&](const std::pair<K, V>& pair) { func(pair); });
+	}
+
+	//	Visits keys within [lo, hi] in ascending order, through the sorted index (Traits::Index). Every value is read under
+	//	the node seqlock, same as read(). Keys present for the whole scan are visited exactly once, keys inserted or
+	//	removed meanwhile might be missed. Scan standing on a node that is changed or removed continues from the
+	//	last visited key, looked up again from the top of the index.
+	template<typename CompatibleK, typename F>	//	func(const std::pair<key, value>&)
+	void visit_range(const CompatibleK& lo, const CompatibleK& hi, F func) requires (Index::Levels != 0)
+	{
+		[[maybe_unused]] auto reader_guard = reclamation.pin();
+		Contention contention(counters);
+
+		const int64_t now = eviction.now();
+		IndexEntry entry;
+		for (bool found = index_seek(lo, true, entry, contention); found && !IndexLess()(hi, entry.item.first); found = index_next(entry, contention))
+			if (!eviction.expired(entry.node_idx, now))
+				func(std::as_const(entry.item));
+	}
+
+	//	All keys in ascending order, same guarantees as visit_range
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit_sorted(F func) requires (Index::Levels != 0)
+	{
+		[[maybe_unused]] auto reader_guard = reclamation.pin();
+		Contention contention(counters);
+
+		const int64_t now = eviction.now();
+		IndexEntry entry;
+		entry.node_idx = IndexHead;
+		while (index_next(entry, contention))
+			if (!eviction.expired(entry.node_idx, now))
+				func(std::as_const(entry.item));
+	}
+
+	//	Visits in place: `project(const K&, const V&)` runs on the node (same rules as for read_with projection),
+	//	`consume(result)` receives its result once the node is validated.
+	template<typename P, typename F>
+	void visit_with(P project, F consume)
+	{
+		using Result = std::invoke_result_t<P&, const K&, const V&>;
+		static_assert(std::is_trivially_destructible_v<Result>, "Projection runs over possibly torn data, its result must not own resources");
+
+		//	Visit goes across all nodes only once, this might miss some of the newly inserted nodes.
+		//  Duplicates are possible if node was visited, deleted and then reinserted.
+		const int64_t now = eviction.now();
+		for (size_t node_idx = 0; node_idx < capacity(); ++node_idx)
+		{
+			//	usual pattern, looking after odd version, version change and part_of_bucket value
+			Contention contention(counters);
+
+			while(true)
+			{
+				NodeRef node = nodes[node_idx];
+				Schedule::point(SchedulePoint::VersionLoad);
+				size_t before_version = node.version.load(std::memory_order_acquire);
+				if (before_version % 2 == 1)
+				{
+					contention.wait(node.version, before_version);
+					continue;
+				}
+
+				Schedule::point(SchedulePoint::NodeRead);
+				if ((node.part_of_bucket & RetiredBucketTag) != 0)
+				{
+					//	empty or removed node, skip..
+					break;
+				}
+
+				Result result = project(std::as_const(node.key), std::as_const(node.value));
+
+				Schedule::point(SchedulePoint::VersionLoad);
+				size_t after_version = node.version.load(std::memory_order_acquire);
+				if (before_version != after_version)
+				{
+					contention.retry();
+					continue;
+				}
+
+				if (!eviction.expired(node_idx, now))
+					consume(result);
+
+				//	done reading this node
+				break;
+			}
+		}
+	}
+	
+protected:
+	//	Shared memory placement of Map - the map itself, or a class built on top of it (LockFreeVarLenHashMap), whose
+	//	extra members follow the map. Header describes the map, its size is of the whole Map.
+	template<typename Map>
+	static constexpr size_t shared_memory_size_of() requires (!DynamicExtent)
+	{
+		return shared_memory_map_offset<Map>() + sizeof(Map);
+	}
+
+	template<typename Map>
+	static Map* create_as(void* memory, size_t size) requires (!DynamicExtent)
+	{
+		if (size < shared_memory_size_of<Map>())
+			throw std::runtime_error("Shared memory: region is too small for the hash map");
+		if (reinterpret_cast<uintptr_t>(memory) % alignof(Map) != 0)
+			throw std::runtime_error("Shared memory: region is misaligned");
+
+		auto* header = new (memory) details::SharedMemoryHeader;
+		header->map_offset = static_cast<uint32_t>(shared_memory_map_offset<Map>());
+		header->node_layout = NodeLayout::Id;
+		header->buckets = Traits::Buckets::Id;
+		header->hash = details::type_fingerprint<Hash>();
+		header->key_equal = details::type_fingerprint<KeyEqual>();
+		header->key_size = sizeof(K);
+		header->value_size = sizeof(V);
+		header->max_elems = MaxElems;
+		header->buckets_num = BucketsNum;
+		header->map_size = sizeof(Map);
+
+		auto* map = new (static_cast<std::byte*>(memory) + header->map_offset) Map;
+
+		//	readers may attach from now on
+		header->ready.store(1, std::memory_order_release);
+		return map;
+	}
+
+	template<typename Map>
+	static Map* attach_as(void* memory, size_t size) requires (!DynamicExtent)
+	{
+		if (size < sizeof(details::SharedMemoryHeader))
+			throw std::runtime_error("Shared memory: region is too small for the header");
+
+		auto* header = std::launder(static_cast<details::SharedMemoryHeader*>(memory));
+		if (header->magic != details::SharedMemoryHeader::Magic)
+			throw std::runtime_error("Shared memory: no hash map found in the region");
+		if (header->ready.load(std::memory_order_acquire) != 1)
+			throw std::runtime_error("Shared memory: hash map is not constructed yet");
+		if (header->layout_version != details::SharedMemoryHeader::LayoutVersion ||
+			header->map_offset != shared_memory_map_offset<Map>() ||
+			header->node_layout != NodeLayout::Id ||
+			header->buckets != Traits::Buckets::Id ||
+			header->key_size != sizeof(K) ||
+			header->value_size != sizeof(V) ||
+			header->max_elems != MaxElems ||
+			header->buckets_num != BucketsNum ||
+			header->map_size != sizeof(Map))
+			throw std::runtime_error("Shared memory: hash map layout mismatch");
+		if (header->hash != details::type_fingerprint<Hash>() || header->key_equal != details::type_fingerprint<KeyEqual>())
+			throw std::runtime_error("Shared memory: hash map was created with another Hash/KeyEqual");
+		if (size < shared_memory_size_of<Map>())
+			throw std::runtime_error("Shared memory: region is truncated");
+
+		return std::launder(reinterpret_cast<Map*>(static_cast<std::byte*>(memory) + header->map_offset));
+	}
+
+private:
+	//	Lookup key is hashed as K unless the hasher is transparent - otherwise e.g. std::hash<int> and std::hash<int64_t> disagree
+	template<typename CompatibleK>
+	static size_t hash_of(const CompatibleK& key)
+	{
+		if constexpr (std::is_same_v<CompatibleK, K> || requires { typename Hash::is_transparent; })
+			return Hash()(key);
+		else
+			return Hash()(static_cast<K>(key));
+	}
+
+	template<typename CompatibleK>
+	size_t bucket_of(const CompatibleK& key) const
+	{
+		return Buckets::index(hash_of(key), buckets.size());
+	}
+
+	template<typename CompatibleK>
+	static bool keys_equal(const K& node_key, const CompatibleK& key)
+	{
+		return KeyEqual()(node_key, key);
+	}
+
+	template<typename Map>
+	static constexpr size_t shared_memory_map_offset()
+	{
+		constexpr size_t align = alignof(Map);
+		return (sizeof(details::SharedMemoryHeader) + align - 1) / align * align;
+	}
+
+	//	`project` result is returned for the node holding `key`, `version` (if given) receives the node and its version read at
+	template<typename CompatibleK, typename F>
+	auto read_from_bucket(size_t bucket_idx, const CompatibleK& key, F&& project, KeyVersion* version = nullptr)
+	{
+		using Result = std::invoke_result_t<F&, const V&>;
+		static_assert(std::is_trivially_destructible_v<Result>, "Projection runs over possibly torn data, its result must not own resources");
+		std::optional<Result> result;
+		Contention contention(counters);
+		//	nodes we walk through stay what they are until we're done (deferred reclamation only)
+		[[maybe_unused]] auto reader_guard = reclamation.pin();
+
+		//	Do full scan of the bucket.
+		// 
+		//	Internally we scan the existing chain, making sure we didn't derail on the way (i.e. checking deleted/reused nodes).
+		//  It is safe to run over deleted nodes because physically these are not deallocated and stay as a part of `nodes` container, keeping their version value.
+		// 
+		//  If we found the node (key matches, even version, not derailed) - we grab the data and prep to exit.
+		//  Before exit we extra check the node version didn't jump. If so, we must read stale data with possible key/value being overwritten - have to abandon and retry.
+		// 
+		//	However if we didn't find the node - we have to do extra check that our root node was intact.
+		//  Deleter updates bucket's root node if anything inside the chain was modified, to notify readers of the change. Readers cannot detect chain alteration otherwise.
+		//  We cannot recover and have to start scanning the chain from scratch.
+		//
+		while(true)
+		{
+		l_restart_from_root:
+			//	remember characteristics of the root node, those have to stay the same once we done reading
+			Schedule::point(SchedulePoint::BucketLoad);
+			const size_t root_node_idx = buckets[bucket_idx].load(std::memory_order_acquire);
+			if (root_node_idx == EmptyBucketTag)
+			{
+				//	Early exit - no root - nothing to worry about
+				result = std::nullopt;
+				if (version)
+					*version = KeyVersion{};
+				return result;
+			}
+
+			size_t node_idx = root_node_idx;
+			while (node_idx != EmptyBucketTag)
+			{
+				//	This part handles only node overwrites, so as far as we found the correct node - we just read and pray it was not overwritten.
+				NodeRef node = nodes[node_idx];
+				Schedule::point(SchedulePoint::VersionLoad);
+				size_t before_version = node.version.load(std::memory_order_acquire);
+				if (before_version % 2 == 1)
+				{
+					//	node is being altered, retrying
+					contention.wait(node.version, before_version);
+					continue;
+				}
+
+				Schedule::point(SchedulePoint::NodeRead);
+				const size_t node_bucket_idx = node.part_of_bucket;
+				if ((node_bucket_idx & ~RetiredBucketTag) != bucket_idx)
+				{
+					//	node was deleted and reused, we got derailed - has to start from the root
+					contention.restart();
+					goto l_restart_from_root;
+				}
+
+				//	Another scenario, node was deleted and readded back into the same bucket. We won't see the change
+				//  (version update could have been completed). Though we will be reading node that stays now earlier in the chain.
+				//	This would lead to chain rescan - something that we want anyways. We will miss the most latest added nodes, 
+				//  as those will stay ahead of the node we are rereading. Which is expected.
+
+				//	removed node (deferred reclamation) is just a link to the rest of the chain
+				if (node_bucket_idx != bucket_idx || !keys_equal(node.key, key))
+				{
+					const size_t next_node_idx = node.next_node;
+
+					//	consuming data from this node is done, we made a decision
+					//	however we've been assuming so far it was intact
+					//	check if it was true
+					Schedule::point(SchedulePoint::VersionLoad);
+					size_t after_version = node.version.load(std::memory_order_acquire);
+					if (before_version == after_version)
+					{
+						node_idx = next_node_idx;
+						continue;
+					}
+					
+					//	if node was updated (say, overwritten) - we need to reread it again
+					contention.retry();
+					continue;
+				}
+
+				//	we reach here if node was found, loading data
+				result.emplace(project(std::as_const(node.value)));
+
+				//	now, same check were we reading over the same version of the node?
+				Schedule::point(SchedulePoint::VersionLoad);
+				size_t after_version = node.version.load(std::memory_order_acquire);
+				if (before_version == after_version)
+				{
+					//	found node and managed to read value fully
+					//	note, we don't mind if anything around us being erased - we're in the correct unaltered node - that's all that matters
+					if (eviction.expired(node_idx, eviction.now()))
+					{
+						//	past its time to live, as good as removed
+						result = std::nullopt;
+						if (version)
+							*version = KeyVersion{};
+						return result;
+					}
+
+					eviction.touch(node_idx);
+					if (version)
+						*version = KeyVersion{ node_idx, before_version };
+					return result;
+				}
+
+				//	nope, version changed - rereading the node, thus we keep node_idx the same
+				contention.retry();
+				continue;
+			}
+
+			//	now we fair and square - scanned all, bucket was intact: no such key
+			result = std::nullopt;
+			if (version)
+				*version = KeyVersion{};
+			return result;
+		}
+	}
+
+	//	Node ownership for concurrent writers. Succeeds only if the node still has the version writer observed while validating it,
+	//	i.e. nobody changed, removed or reused the node in between. Owner is the only one to change the node until unlock.
+	static bool try_lock_node(NodeRef node, size_t observed_version)
+	{
+		assert(observed_version % 2 == 0);
+		Schedule::point(SchedulePoint::NodeWrite);
+		return node.version.compare_exchange_strong(observed_version, observed_version + 1, std::memory_order_acq_rel);
+	}
+
+	static void unlock_node(NodeRef node, size_t observed_version)
+	{
+		Schedule::point(SchedulePoint::NodeWrite);
+		node.version.store(observed_version + 2, std::memory_order_release);
+		Backoff::notify(node.version);
+	}
+
+	//	Same as read_from_bucket walk, but for a concurrent writer: locates the node with `key` and the node before it,
+	//	remembering versions those were validated at. Returns false if key is not in the bucket.
+	struct ChainPosition
+	{
+		size_t root_node_idx = EmptyBucketTag;
+		size_t root_version = 0;
+		size_t previous_node_idx = EmptyBucketTag;
+		size_t previous_version = 0;
+		size_t node_idx = EmptyBucketTag;
+		size_t node_version = 0;
+		size_t chain_length = 0;	//	nodes passed
+	};
+
+	template<typename CompatibleK>
+	bool find_concurrent(size_t bucket_idx, const CompatibleK& key, ChainPosition& pos)
+	{
+		Contention contention(counters);
+
+	l_restart_from_root:
+		pos = ChainPosition{};
+		Schedule::point(SchedulePoint::BucketLoad);
+		pos.root_node_idx = buckets[bucket_idx].load(std::memory_order_acquire);
+
+		size_t node_idx = pos.root_node_idx;
+		while (node_idx != EmptyBucketTag)
+		{
+			NodeRef node = nodes[node_idx];
+			Schedule::point(SchedulePoint::VersionLoad);
+			size_t before_version = node.version.load(std::memory_order_acquire);
+			if (before_version % 2 == 1)
+			{
+				contention.wait(node.version, before_version);
+				continue;
+			}
+
+			Schedule::point(SchedulePoint::NodeRead);
+			if (node.part_of_bucket != bucket_idx)
+			{
+				contention.restart();
+				goto l_restart_from_root;
+			}
+
+			const bool found = keys_equal(node.key, key);
+			const size_t next_node_idx = node.next_node;
+
+			Schedule::point(SchedulePoint::VersionLoad);
+			size_t after_version = node.version.load(std::memory_order_acquire);
+			if (before_version != after_version)
+			{
+				contention.retry();
+				continue;
+			}
+
+			if (node_idx == pos.root_node_idx)
+				pos.root_version = before_version;
+
+			if (found)
+			{
+				pos.node_idx = node_idx;
+				pos.node_version = before_version;
+				return true;
+			}
+
+			pos.previous_node_idx = node_idx;
+			pos.previous_version = before_version;
+			node_idx = next_node_idx;
+			++pos.chain_length;
+		}
+
+		return false;
+	}
+
+	//	Where the writer found the key in its bucket chain, node_idx is EmptyBucketTag if the key is absent
+	struct WriterPosition
+	{
+		size_t previous_node_idx = EmptyBucketTag;
+		size_t node_idx = EmptyBucketTag;
+		size_t chain_length = 0;	//	nodes before the key, or the whole chain if absent
+	};
+
+	//	Single writer, nobody else changes the chain - no need to guard reading it
+	template<typename CompatibleK>
+	WriterPosition find_for_write(size_t bucket_idx, const CompatibleK& key)
+	{
+		WriterPosition pos;
+		pos.node_idx = buckets[bucket_idx].load(std::memory_order_relaxed);
+		while (pos.node_idx != EmptyBucketTag)
+		{
+			NodeRef node = nodes[pos.node_idx];
+			if (keys_equal(node.key, key))
+				break;
+
+			pos.previous_node_idx = pos.node_idx;
+			pos.node_idx = node.next_node;
+			++pos.chain_length;
+		}
+
+		return pos;
+	}
+
+	//	Common part of store/store_if_absent/upsert: `update(V&)` runs on the value of the found key (unless UpdateIfFound is false),
+	//	`init(V&)` on the value of the inserted node. Returns true if the key was inserted.
+	template<bool UpdateIfFound, typename U, typename I>
+	bool write(const K& key, U&& update, I&& init)
+	{
+		const size_t bucket_idx = bucket_of(key);
+		Mutation mutation(*this, bucket_idx);
+		if constexpr (Writers::Concurrent)
+			return write_concurrent<UpdateIfFound>(bucket_idx, key, update, init);
+		else
+		{
+			const WriterPosition pos = find_for_write(bucket_idx, key);
+			if (pos.node_idx != EmptyBucketTag)
+			{
+				if constexpr (UpdateIfFound)
+				{
+					eviction.updated(pos.node_idx);
+					update_node(nodes[pos.node_idx], bucket_idx, update);
+				}
+				return false;
+			}
+
+			insert_node(bucket_idx, key, init, pos.chain_length);
+			return true;
+		}
+	}
+
+	template<typename U>
+	static void update_node(NodeRef node, size_t bucket_idx, U&& update)
+	{
+		//	version is odd (readers stay away)
+		begin_write(node);
+		//	update value
+		update(node.value);
+		node.part_of_bucket = bucket_idx;
+		//	mark version as even (readers good to go (but may need to reread))
+		end_write(node);
+	}
+
+	template<typename I>
+	void insert_node(size_t bucket_idx, const K& key, I&& init, size_t chain_length)
+	{
+		//	Alloc new node, by doing linked list (new node enters first),
+		//	current root node is pushed down and becomes next node.
+		//	This way, readers can navigate existing chain down safely - new node will just stay invisible
+		const size_t node_idx = alloc_node();
+		NodeRef node = nodes[node_idx];
+		assert(node.part_of_bucket == EmptyBucketTag);
+		assert(node.next_node == EmptyBucketTag);
+		
+		node.placement_new();
+		eviction.inserted(node_idx);
+
+		begin_write(node);
+		node.key = key;
+		Schedule::point(SchedulePoint::NodeWrite);
+		init(node.value);
+		node.next_node = buckets[bucket_idx].load(std::memory_order_relaxed);
+		node.part_of_bucket = bucket_idx;
+		end_write(node);
+
+		//	At this point we got new node that correctly looks at our root node as next. So readers are oblivious to the addition and
+		//	can navigate existing chain. No existing nodes are updated.
+		//  However now we replace the root of the bucket to make it public.
+		Schedule::point(SchedulePoint::BucketStore);
+		buckets[bucket_idx].store(node_idx, std::memory_order_release);
+		counters.chain_length(chain_length + 1);
+		index_insert(node_idx);
+	}
+
+	//	store_batch part for a single bucket, `group` holds positions of its pairs in `items`. Returns number of keys inserted.
+	size_t store_group(size_t bucket_idx, std::span<const std::pair<K, V>> items, std::span<const size_t> group)
+	{
+		const size_t published_root_idx = buckets[bucket_idx].load(std::memory_order_relaxed);
+		//	new nodes are chained in front of the published root, readers see them all at once when the group is done
+		size_t root_node_idx = published_root_idx;
+		auto publish = [&] {
+			if (root_node_idx == published_root_idx)
+				return;
+
+			Schedule::point(SchedulePoint::BucketStore);
+			buckets[bucket_idx].store(root_node_idx, std::memory_order_release);
+			for (size_t node_idx = root_node_idx; node_idx != published_root_idx; node_idx = nodes[node_idx].next_node.load(std::memory_order_relaxed))
+				index_insert(node_idx);
+		};
+
+		size_t inserted = 0;
+		try
+		{
+			for (size_t item_idx : group)
+			{
+				const auto& [key, value] = items[item_idx];
+
+				//	single writer, nobody else changes the chain - no need to guard reading it
+				size_t node_idx = root_node_idx;
+				bool published = node_idx == published_root_idx;
+				size_t chain_length = 0;
+				while (node_idx != EmptyBucketTag && !keys_equal(nodes[node_idx].key, key))
+				{
+					node_idx = nodes[node_idx].next_node.load(std::memory_order_relaxed);
+					published = published || node_idx == published_root_idx;
+					++chain_length;
+				}
+
+				if (node_idx != EmptyBucketTag)
+				{
+					NodeRef node = nodes[node_idx];
+					write_exclusive(node, published, [&] {
+						node.value = value;
+						node.part_of_bucket = bucket_idx;
+					});
+					continue;
+				}
+
+				node_idx = alloc_node();
+				NodeRef node = nodes[node_idx];
+				assert(node.part_of_bucket == EmptyBucketTag);
+				assert(node.next_node == EmptyBucketTag);
+
+				node.placement_new();
+				write_exclusive(node, false, [&] {
+					node.key = key;
+					node.value = value;
+					node.next_node.store(root_node_idx, std::memory_order_relaxed);
+					node.part_of_bucket = bucket_idx;
+				});
+
+				root_node_idx = node_idx;
+				counters.chain_length(chain_length + 1);
+				++inserted;
+			}
+		}
+		catch (...)
+		{
+			publish();
+			throw;
+		}
+
+		publish();
+		return inserted;
+	}
+
+	//	Seqlock write section of a node only the single writer changes: plain stores of the version, no read-modify-writes.
+	//	Skipped altogether for a node not published yet, if no reader can be standing on it either: never used before
+	//	(version 0), or reused only once readers which might have seen it are gone (deferred reclamation).
+	template<typename W>
+	static void write_exclusive(NodeRef node, bool published, W&& write)
+	{
+		const size_t version = node.version.load(std::memory_order_relaxed);
+		if (!published && (Reclamation::Deferred || version == 0))
+		{
+			write();
+			return;
+		}
+
+		node.version.store(version + 1, std::memory_order_relaxed);
+		//	odd version is visible before any of the writes below
+		std::atomic_thread_fence(std::memory_order_release);
+		Schedule::point(SchedulePoint::NodeWrite);
+		write();
+		Schedule::point(SchedulePoint::NodeWrite);
+		node.version.store(version + 2, std::memory_order_release);
+		Backoff::notify(node.version);
+	}
+
+	void unlink_node(size_t bucket_idx, const WriterPosition& pos)
+	{
+		index_remove(pos.node_idx);
+		NodeRef node = nodes[pos.node_idx];
+
+		//	Relink parent node, now it points to the node after. For reader, the chain is in correct state, and current node looks already deleted.
+		//	If reader didn't yet manage to read old `next_node` link, futher changes will be transparent.
+		//	Note, that readed will have to reread the parent node if it read it during it's update and later detected version change.
+		size_t next_node_idx = node.next_node;
+		if (pos.previous_node_idx != EmptyBucketTag)
+		{
+			NodeRef previous_node = nodes[pos.previous_node_idx];
+
+			begin_write(previous_node);
+			previous_node.next_node = next_node_idx;
+			end_write(previous_node);
+		}
+		else
+		{
+			//	Here we know that being deleted node is the root node.
+			assert(buckets[bucket_idx].load(std::memory_order_relaxed) == pos.node_idx);
+			//	Update bucket
+			Schedule::point(SchedulePoint::BucketStore);
+			buckets[bucket_idx].store(next_node_idx, std::memory_order_release);
+		}
+
+		//	Now, mark node as destroyed
+		//	In case if client is reading this node, it might lose the ability to continue, because the next_node info was lost (or even reused).
+		//	In such case, client should detect it derailed seeing `part_of_bucket` mismatch.
+		//	In the edge case when `part_of_bucket` coincides after deletion and reusing - this is the scenario when reader looking at the node that was moved
+		//	back to the beginning of the chain - safe to keep using it.
+		if constexpr (Reclamation::Deferred)
+		{
+			//	Node keeps its key and links, readers passing through it skip it and continue. Reused once they are gone.
+			begin_write(node);
+			node.part_of_bucket = bucket_idx | RetiredBucketTag;
+			end_write(node);
+			reclamation.retire(pos.node_idx, [this](size_t retired_idx) { free_node(retired_idx); });
+			return;
+		}
+
+		free_node(pos.node_idx);
+	}
+
+	template<bool UpdateIfFound, typename U, typename I>
+	bool write_concurrent(size_t bucket_idx, const K& key, U&& update, I&& init)
+	{
+		Contention contention(counters);
+
+		//	node prepared for insertion, kept between attempts
+		size_t new_node_idx = EmptyBucketTag;
+
+		while (true)
+		{
+			ChainPosition pos;
+			if (find_concurrent(bucket_idx, key, pos))
+			{
+				if constexpr (UpdateIfFound)
+				{
+					NodeRef node = nodes[pos.node_idx];
+					if (!try_lock_node(node, pos.node_version))
+					{
+						//	changed since found, maybe even removed
+						contention.retry();
+						continue;
+					}
+
+					update(node.value);
+					unlock_node(node, pos.node_version);
+				}
+
+				if (new_node_idx != EmptyBucketTag)
+				{
+					//	somebody else inserted the key while we were trying, prepared node is not needed
+					NodeRef new_node = nodes[new_node_idx];
+					begin_write(new_node);
+					new_node.destroy();
+					new_node.part_of_bucket = EmptyBucketTag;
+					new_node.next_node = EmptyBucketTag;
+					end_write(new_node);
+					node_allocator.free(new_node_idx);
+				}
+				return false;
+			}
+
+			if (new_node_idx == EmptyBucketTag)
+			{
+				new_node_idx = alloc_node();
+				NodeRef new_node = nodes[new_node_idx];
+				assert(new_node.part_of_bucket == EmptyBucketTag);
+
+				//	Freshly allocated node belongs to us, nobody can lock it. Versions are still bumped for readers derailed onto it.
+				begin_write(new_node);
+				new_node.placement_new();
+				new_node.key = key;
+				init(new_node.value);
+				new_node.part_of_bucket = bucket_idx;
+				end_write(new_node);
+			}
+
+			//	Lock the root we have scanned from. Other writers wanting to insert or to remove the root have to lock it too,
+			//	so while we hold it the root can't change, and the key can't appear in the chain (inserts go only in front of the root).
+			//	Without this the root could be removed and reinserted with our key in between (ABA) and CAS on the bucket would succeed.
+			//	CAS still fails if the root was replaced before we observed its version - then the chain is rescanned.
+			NodeRef new_node = nodes[new_node_idx];
+			if (pos.root_node_idx != EmptyBucketTag && !try_lock_node(nodes[pos.root_node_idx], pos.root_version))
+			{
+				contention.retry();
+				continue;
+			}
+
+			begin_write(new_node);
+			new_node.next_node = pos.root_node_idx;
+			end_write(new_node);
+
+			size_t expected_root = pos.root_node_idx;
+			Schedule::point(SchedulePoint::BucketStore);
+			const bool published = buckets[bucket_idx].compare_exchange_strong(expected_root, new_node_idx, std::memory_order_acq_rel);
+
+			if (pos.root_node_idx != EmptyBucketTag)
+				unlock_node(nodes[pos.root_node_idx], pos.root_version);
+
+			if (published)
+			{
+				counters.chain_length(pos.chain_length + 1);
+				return true;
+			}
+
+			contention.retry();
+		}
+	}
+
+	template<typename CompatibleK, typename P>
+	bool remove_concurrent(size_t bucket_idx, const CompatibleK& key, P&& pred)
+	{
+		Contention contention(counters);
+
+		while (true)
+		{
+			ChainPosition pos;
+			if (!find_concurrent(bucket_idx, key, pos))
+				return false;
+
+			//	Locking in chain order, previous node first. With the previous node locked nobody can unlink or change it,
+			//	so it still points to our node. With our node locked nobody can unlink whatever follows it.
+			NodeRef node = nodes[pos.node_idx];
+			if (pos.previous_node_idx != EmptyBucketTag)
+			{
+				NodeRef previous_node = nodes[pos.previous_node_idx];
+				if (!try_lock_node(previous_node, pos.previous_version))
+				{
+					contention.retry();
+					continue;
+				}
+
+				if (!try_lock_node(node, pos.node_version))
+				{
+					unlock_node(previous_node, pos.previous_version);
+					contention.retry();
+					continue;
+				}
+
+				//	value can't change while locked
+				if (!pred(std::as_const(node.value)))
+				{
+					unlock_node(node, pos.node_version);
+					unlock_node(previous_node, pos.previous_version);
+					return false;
+				}
+
+				previous_node.next_node = node.next_node.load(std::memory_order_relaxed);
+				unlock_node(previous_node, pos.previous_version);
+			}
+			else
+			{
+				if (!try_lock_node(node, pos.node_version))
+				{
+					contention.retry();
+					continue;
+				}
+
+				if (!pred(std::as_const(node.value)))
+				{
+					unlock_node(node, pos.node_version);
+					return false;
+				}
+
+				//	Root changes only under the lock of the root node, which we hold now. However it might have stopped
+				//	being the root before we observed its version - then the node has a predecessor now, rescanning.
+				size_t expected_root = pos.node_idx;
+				Schedule::point(SchedulePoint::BucketStore);
+				if (!buckets[bucket_idx].compare_exchange_strong(expected_root, node.next_node.load(std::memory_order_relaxed), std::memory_order_acq_rel))
+				{
+					unlock_node(node, pos.node_version);
+					contention.retry();
+					continue;
+				}
+			}
+
+			//	node is ours and unreachable, same retirement as single writer remove
+			node.destroy();
+			node.part_of_bucket = EmptyBucketTag;
+			node.next_node = EmptyBucketTag;
+			unlock_node(node, pos.node_version);
+			node_allocator.free(pos.node_idx);
+
+			return true;
+		}
+	}
+
+	//	Backoff of a single operation. Counts retries (node was being changed) and restarts (derailed, rescan from the root),
+	//	those are reported to stats once operation is over - nothing is written into shared counters on the uncontended path.
+	class Contention
+	{
+	public:
+		explicit Contention(StatsCounters& counters) : counters(counters) {}
+		~Contention()
+		{
+			if (retries != 0 || restarts != 0)
+				counters.contended(retries, restarts);
+		}
+
+		Contention(const Contention&) = delete;
+		Contention& operator=(const Contention&) = delete;
+
+		void retry() { ++retries; Schedule::point(SchedulePoint::Retry); backoff.pause(); }
+		void restart() { ++restarts; Schedule::point(SchedulePoint::Retry); backoff.pause(); }
+		//	node was seen with odd `odd_version`, waiting for writer to finish
+		void wait(const std::atomic<size_t>& version, size_t odd_version) { ++retries; Schedule::point(SchedulePoint::Retry); backoff.wait(version, odd_version); }
+
+	private:
+		StatsCounters& counters;
+		typename Backoff::State backoff;
+		size_t retries = 0;
+		size_t restarts = 0;
+	};
+
+	//	Brackets every store/remove, so snapshot() can tell whether the map changed under its scan.
+	//	Once done, wakes up readers waiting on the bucket changed (all of them for EmptyBucketTag).
+	class Mutation
+	{
+	public:
+		explicit Mutation(LockFreeFixedSizeHashMap& map, size_t bucket_idx = EmptyBucketTag) : map(map), bucket_idx(bucket_idx)
+		{
+			//	seq_cst pairs with try_snapshot: scan which has read what this mutation changes sees it started
+			map.mutations_started.fetch_add(1, std::memory_order_seq_cst);
+		}
+
+		~Mutation()
+		{
+			map.mutations_finished.fetch_add(1, std::memory_order_seq_cst);
+			map.waiters.notify(bucket_idx, map.buckets.size());
+		}
+
+		Mutation(const Mutation&) = delete;
+		Mutation& operator=(const Mutation&) = delete;
+
+	private:
+		LockFreeFixedSizeHashMap& map;
+		const size_t bucket_idx;
+	};
+
+	template<typename Rep, typename Period>
+	static details::KeyWaiters::Clock::time_point deadline_after(std::chrono::duration<Rep, Period> timeout)
+	{
+		using Clock = details::KeyWaiters::Clock;
+		const auto now = Clock::now();
+		//	saturates instead of overflowing for "forever" timeouts
+		if (std::chrono::duration<double>(timeout) >= std::chrono::duration<double>(Clock::time_point::max() - now))
+			return Clock::time_point::max();
+		return now + std::chrono::duration_cast<Clock::duration>(timeout);
+	}
+
+	static constexpr size_t SnapshotAttempts = 64;
+	//	partitions of the first bulk_load sorting level
+	static constexpr size_t BulkLoadPartitionsMax = 1024;
+	//	pairs store_batch prefetches and groups at once
+	static constexpr size_t BatchWindowSize = 16;
+
+	//	Copies all nodes into `result`, true if nothing was written to the map meanwhile
+	bool try_snapshot(Snapshot& result)
+	{
+		const size_t started = mutations_started.load(std::memory_order_seq_cst);
+		if (mutations_finished.load(std::memory_order_seq_cst) != started)
+			return false;
+
+		result.items.clear();
+		visit_with([](const K& key, const V& value) { return std::make_pair(key, value); },
+			[&](const std::pair<K, V>& pair) { result.items.push_back(pair); });
+
+		//	Any write touching the nodes we've read has to be started (and counted) before it changes them
+		if (mutations_started.load(std::memory_order_seq_cst) != started)
+			return false;
+
+		result.generation = started;
+		return true;
+	}
+
+	//	Sorted index (Traits::Index). Writer keeps every live node linked into the skip list in key order: new node gets its
+	//	own links first and is then linked in bottom up, removed node is unlinked top down before it is freed or retired.
+	//	Readers follow the links hand over hand - node is taken only if its predecessor still links to it once the node is
+	//	read, and the predecessor itself is unchanged (same version), otherwise the node might have been removed and reused.
+
+	using IndexLess = typename Index::Less;
+	static constexpr size_t IndexHead = std::numeric_limits<size_t>::max() - 1;
+
+	//	Node a reader has read out of the index
+	struct IndexEntry
+	{
+		size_t node_idx = EmptyBucketTag;
+		size_t version = 0;
+		std::pair<K, V> item;
+	};
+
+	enum class IndexStep
+	{
+		Found,
+		End,		//	no more nodes after
+		Restart,	//	predecessor has changed, lookup has to start over
+	};
+
+	//	Number of lists the key is linked into - picked by the hash, so the writer needs no random state
+	static size_t index_levels_of(const K& key)
+	{
+		const uint64_t mixed = details::mum(hash_of(key), 0x9E3779B97F4A7C15ULL) | (uint64_t(1) << 63);
+		return 1 + std::min<size_t>(Index::Levels - 1, std::countr_zero(mixed) / 2);
+	}
+
+	//	Writer. Last node of every list with key less than `key` (IndexHead if none).
+	void index_find_predecessors(const K& key, std::array<size_t, Index::Levels>& predecessors)
+	{
+		size_t node_idx = IndexHead;
+		for (size_t level = Index::Levels; level-- > 0;)
+		{
+			for (size_t next_idx = index_links.at(node_idx, level).load(std::memory_order_relaxed);
+				next_idx != EmptyBucketTag && IndexLess()(nodes[next_idx].key, key);
+				next_idx = index_links.at(node_idx, level).load(std::memory_order_relaxed))
+				node_idx = next_idx;
+			predecessors[level] = node_idx;
+		}
+	}
+
+	void index_insert(size_t node_idx)
+	{
+		if constexpr (Index::Levels != 0)
+		{
+			std::array<size_t, Index::Levels> predecessors;
+			index_find_predecessors(nodes[node_idx].key, predecessors);
+
+			const size_t levels = index_levels_of(nodes[node_idx].key);
+			for (size_t level = 0; level < levels; ++level)
+				index_links.at(node_idx, level).store(index_links.at(predecessors[level], level).load(std::memory_order_relaxed), std::memory_order_relaxed);
+			for (size_t level = 0; level < levels; ++level)
+				index_links.at(predecessors[level], level).store(node_idx, std::memory_order_release);
+		}
+	}
+
+	void index_remove(size_t node_idx)
+	{
+		if constexpr (Index::Levels != 0)
+		{
+			std::array<size_t, Index::Levels> predecessors;
+			index_find_predecessors(nodes[node_idx].key, predecessors);
+
+			//	removed node keeps its links, reader standing on it can still go on (it'll find the node changed and restart anyway)
+			for (size_t level = index_levels_of(nodes[node_idx].key); level-- > 0;)
+			{
+				assert(index_links.at(predecessors[level], level).load(std::memory_order_relaxed) == node_idx);
+				index_links.at(predecessors[level], level).store(index_links.at(node_idx, level).load(std::memory_order_relaxed), std::memory_order_release);
+			}
+		}
+	}
+
+	//	Writer, links all nodes of the map at once (bulk_load): sorted by key, every list is built front to back
+	void index_build()
+	{
+		if constexpr (Index::Levels != 0)
+		{
+			std::vector<size_t> sorted;
+			for (size_t bucket_idx = 0; bucket_idx < buckets.size(); ++bucket_idx)
+				for (size_t node_idx = buckets[bucket_idx].load(std::memory_order_relaxed); node_idx != EmptyBucketTag; node_idx = nodes[node_idx].next_node.load(std::memory_order_relaxed))
+					sorted.push_back(node_idx);
+			std::sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b) { return IndexLess()(nodes[a].key, nodes[b].key); });
+
+			std::array<size_t, Index::Levels> last;
+			last.fill(IndexHead);
+			for (size_t node_idx : sorted)
+			{
+				const size_t levels = index_levels_of(nodes[node_idx].key);
+				for (size_t level = 0; level < levels; ++level)
+				{
+					index_links.at(node_idx, level).store(EmptyBucketTag, std::memory_order_relaxed);
+					index_links.at(last[level], level).store(node_idx, std::memory_order_release);
+					last[level] = node_idx;
+				}
+			}
+		}
+	}
+
+	bool index_node_unchanged(size_t node_idx, size_t version)
+	{
+		return node_idx == IndexHead || nodes[node_idx].version.load(std::memory_order_acquire) == version;
+	}
+
+	//	Reader. Reads the node following `predecessor` (taken at `predecessor_version`) in the list of `level` into `entry`,
+	//	value only if `with_value`.
+	IndexStep index_step(size_t predecessor, size_t predecessor_version, size_t level, bool with_value, IndexEntry& entry, Contention& contention)
+	{
+		while (true)
+		{
+			const size_t node_idx = index_links.at(predecessor, level).load(std::memory_order_acquire);
+			if (node_idx == EmptyBucketTag)
+				return index_node_unchanged(predecessor, predecessor_version) ? IndexStep::End : IndexStep::Restart;
+
+			NodeRef node = nodes[node_idx];
+			const size_t before_version = node.version.load(std::memory_order_acquire);
+			if (before_version % 2 == 1)
+			{
+				contention.wait(node.version, before_version);
+				continue;
+			}
+
+			//	speculative, valid only if the version stays the same
+			const size_t node_bucket_idx = node.part_of_bucket;
+			entry.item.first = node.key;
+			if (with_value)
+				entry.item.second = node.value;
+
+			if (node.version.load(std::memory_order_acquire) != before_version)
+			{
+				contention.retry();
+				continue;
+			}
+
+			if (!index_node_unchanged(predecessor, predecessor_version))
+			{
+				contention.restart();
+				return IndexStep::Restart;
+			}
+
+			//	Predecessor still links to the node, so the node is in the list - unless it was read while removed, and got
+			//	reused and linked right here again since then
+			if (index_links.at(predecessor, level).load(std::memory_order_acquire) != node_idx || (node_bucket_idx & RetiredBucketTag) != 0)
+			{
+				contention.retry();
+				continue;
+			}
+
+			entry.node_idx = node_idx;
+			entry.version = before_version;
+			return IndexStep::Found;
+		}
+	}
+
+	//	Reader. First node with key not less than `bound` (greater than, if not `inclusive`).
+	template<typename CompatibleK>
+	bool index_seek(const CompatibleK& bound, bool inclusive, IndexEntry& entry, Contention& contention)
+	{
+	l_restart_from_head:
+		size_t predecessor = IndexHead;
+		size_t predecessor_version = 0;
+		for (size_t level = Index::Levels; level-- > 0;)
+		{
+			while (true)
+			{
+				IndexEntry next;
+				const IndexStep step = index_step(predecessor, predecessor_version, level, level == 0, next, contention);
+				if (step == IndexStep::Restart)
+					goto l_restart_from_head;
+				if (step == IndexStep::End)
+					break;
+
+				const bool before_bound = inclusive ? IndexLess()(next.item.first, bound) : !IndexLess()(bound, next.item.first);
+				if (!before_bound)
+				{
+					if (level != 0)
+						break;
+
+					entry = next;
+					return true;
+				}
+
+				predecessor = next.node_idx;
+				predecessor_version = next.version;
+			}
+		}
+
+		return false;
+	}
+
+	//	Reader. Moves `entry` to the node following it, false if there is none.
+	bool index_next(IndexEntry& entry, Contention& contention)
+	{
+		IndexEntry next;
+		IndexStep step = index_step(entry.node_idx, entry.version, 0, true, next, contention);
+		if (step == IndexStep::Restart)
+			step = index_seek(entry.item.first, false, next, contention) ? IndexStep::Found : IndexStep::End;
+
+		entry = next;
+		return step == IndexStep::Found;
+	}
+
+	//	Seqlock write section of a node: odd version keeps readers away, even lets them in (and wakes up the waiting ones)
+	static void begin_write(NodeRef node)
+	{
+		node.version.fetch_add(1, std::memory_order_acq_rel);
+		Schedule::point(SchedulePoint::NodeWrite);
+	}
+
+	static void end_write(NodeRef node)
+	{
+		Schedule::point(SchedulePoint::NodeWrite);
+		node.version.fetch_add(1, std::memory_order_acq_rel);
+		Backoff::notify(node.version);
+	}
+
+	size_t alloc_node()
+	{
+		try
+		{
+			return node_allocator.alloc();
+		}
+		catch (const std::runtime_error&)
+		{
+			//	full, but some of the nodes might be just waiting for readers to leave
+			if constexpr (Reclamation::Deferred)
+				if (reclamation.reclaim([this](size_t retired_idx) { free_node(retired_idx); }, true))
+					return node_allocator.alloc();
+
+			//	or some key can go, its node is free right away (or once readers leave it)
+			if constexpr (Eviction::Enabled)
+				if (evict_one())
+				{
+					if constexpr (Reclamation::Deferred)
+						reclamation.reclaim([this](size_t retired_idx) { free_node(retired_idx); }, true);
+					return node_allocator.alloc();
+				}
+
+			counters.overflow();
+			throw;
+		}
+	}
+
+	//	Eviction (Traits::Eviction), map is full. The hand goes around the nodes, first live key found expired or not read
+	//	since the last turn is evicted. Two turns at most, the first one clears every reference bit. False if there are
+	//	no live keys (all nodes are removed, waiting for readers).
+	bool evict_one()
+	{
+		const int64_t now = eviction.now();
+		for (size_t swept = 0; swept < 2 * capacity(); ++swept)
+		{
+			const size_t node_idx = eviction.advance(capacity());
+			//	free (EmptyBucketTag) or retired
+			if ((nodes[node_idx].part_of_bucket & RetiredBucketTag) != 0)
+				continue;
+			if (!eviction.expired(node_idx, now) && eviction.second_chance(node_idx))
+				continue;
+
+			evict_node(node_idx);
+			return true;
+		}
+		return false;
+	}
+
+	void evict_node(size_t node_idx)
+	{
+		NodeRef node = nodes[node_idx];
+		const size_t bucket_idx = node.part_of_bucket;
+		unlink_node(bucket_idx, find_for_write(bucket_idx, node.key));
+		counters.evicted();
+
+		//	readers might wait for the key on another bucket than the one being written
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		waiters.notify(bucket_idx, buckets.size());
+	}
+
+	void free_node(size_t node_idx)
+	{
+		NodeRef node = nodes[node_idx];
+		begin_write(node);
+		node.destroy();
+		node.part_of_bucket = EmptyBucketTag;
+		node.next_node = EmptyBucketTag;
+		end_write(node);
+		node_allocator.free(node_idx);
+	}
+
+	alignas(64) details::FixedArray<std::atomic<size_t>, BucketsNum> buckets;	//	slot marked as EmptyBucketTag - empty
+	alignas(64) typename NodeLayout::template Storage<K, V, MaxElems> nodes;
+	alignas(64) typename Writers::template Allocator<MaxElems> node_allocator;
+	[[no_unique_address]] StatsCounters counters;
+	[[no_unique_address]] typename Reclamation::template Domain<MaxElems> reclamation;
+	[[no_unique_address]] typename Index::template Links<MaxElems> index_links;
+	[[no_unique_address]] typename Eviction::template Domain<MaxElems> eviction;
+	//	snapshot() support, bumped by every store/remove
+	alignas(64) std::atomic<size_t> mutations_started = 0;
+	std::atomic<size_t> mutations_finished = 0;
+	details::KeyWaiters waiters;
+};
+
+
+namespace details {
+	template<typename K, typename V, typename NodeLayout>
+	concept FitsAtomicSlot = std::is_same_v<NodeLayout, hashmap_policy::AtomicSlots> && hashmap_policy::AtomicSlots::Fits<K, V>;
+}
+
+//	Map with NodeLayout = hashmap_policy::AtomicSlots, for key/value pairs fitting 16 bytes (see AtomicSlots).
+//	Supports store, store_if_absent, remove (writer), read/read_with (reader/writer, wait free), visit (reader/writer).
+template<typename K, typename V, size_t MaxElems, typename Traits>
+	requires details::TriviallyCopyablePair<K, V> && details::FitsAtomicSlot<K, V, typename Traits::NodeLayout>
+class LockFreeFixedSizeHashMap<K, V, MaxElems, Traits>
+{
+	using Hash = typename Traits::template Hash<K>;
+	using KeyEqual = typename Traits::KeyEqual;
+	using StatsCounters = typename Traits::Stats::Counters;
+	using Slot = hashmap_policy::AtomicSlots::Slot<K, V>;
+	static_assert(!Traits::Writers::Concurrent, "Atomic slots support single writer only");
+	static_assert(MaxElems != std::dynamic_extent, "Atomic slots support compile time capacity only");
+	static_assert(!Traits::Eviction::Enabled, "Atomic slots do not support eviction");
+	static_assert(!Traits::Reclamation::Deferred, "Atomic slots are never reused under readers, nothing to reclaim");
+	static_assert(Traits::Index::Levels == 0, "Atomic slots do not support the sorted index");
+	static_assert(std::is_same_v<typename Traits::Backoff, hashmap_policy::LinearBackoff>, "Atomic slots never retry, nothing to back off");
+	static_assert(std::is_same_v<typename Traits::Buckets, hashmap_policy::PrimeModulo>, "Atomic slots are open addressed, there are no buckets");
+	static_assert(std::is_same_v<typename Traits::Schedule, hashmap_policy::NoSchedulePoints>, "Atomic slots have no schedule points");
+
+	//	load factor is kept at 1/2 at most, probing sequences stay short
+	static constexpr size_t SlotsNum = std::bit_ceil(MaxElems * 2);
+	//	Meta word of a slot: lowest bit - slot is taken, the rest counts keys which probed past this slot.
+	//	Lookup stops at the first slot nothing has overflowed from, so removal leaves no tombstones.
+	static constexpr uint64_t TakenBit = 1;
+	static constexpr uint64_t OverflowStep = 2;
+	static constexpr size_t NoSlot = std::numeric_limits<size_t>::max();
+
+public:
+	using key_type = K;
+	using mapped_type = V;
+	using hasher = Hash;
+
+	size_t capacity() const
+	{
+		return MaxElems;
+	}
+
+	//	Returns true if the key was inserted, false if its value was overwritten
+	bool store(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	{
+		return write<true>(key, value);
+	}
+
+	bool store_if_absent(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	{
+		return write<false>(key, value);
+	}
+
+	template<typename CompatibleK>
+	std::optional<V> read(const CompatibleK& key)
+	{
+		return read_with(key, [](const V& value) { return value; });
+	}
+
+	//	Wait free: one load of the meta word and one of the slot per probed slot, no retries.
+	//	Key present all the time stays in its slot and every slot before it on the probing path advertises overflow,
+	//	so it can't be missed. Projection runs on a copy of the value, no speculation.
+	template<typename CompatibleK, typename F>
+	auto read_with(const CompatibleK& key, F&& project)
+	{
+		using Result = std::invoke_result_t<F&, const V&>;
+
+		const size_t home_idx = home_slot_of(key);
+		for (size_t probe = 0; probe < SlotsNum; ++probe)
+		{
+			const size_t slot_idx = (home_idx + probe) & (SlotsNum - 1);
+			const uint64_t meta = metas[slot_idx].load(std::memory_order_acquire);
+			if ((meta & TakenBit) != 0)
+			{
+				const Slot slot = slots[slot_idx].template load<Slot>();
+				if (keys_equal(slot.key, key))
+					return std::optional<Result>(project(std::as_const(slot.value)));
+			}
+
+			if (meta < OverflowStep)
+				break;
+		}
+
+		return std::optional<Result>();
+	}
+
+	template<typename CompatibleK>
+	bool remove(const CompatibleK& key)
+	{
+		const size_t home_idx = home_slot_of(key);
+		const size_t probe = find_probe(home_idx, key);
+		if (probe == NoSlot)
+			return false;
+
+		auto& meta = metas[(home_idx + probe) & (SlotsNum - 1)];
+		meta.store(meta.load(std::memory_order_relaxed) & ~TakenBit, std::memory_order_release);
+
+		//	key is gone, only now slots on its way may stop advertising overflow
+		for (size_t passed = 0; passed < probe; ++passed)
+		{
+			auto& passed_meta = metas[(home_idx + passed) & (SlotsNum - 1)];
+			passed_meta.store(passed_meta.load(std::memory_order_relaxed) - OverflowStep, std::memory_order_release);
+		}
+
+		--elems_num;
+		return true;
+	}
+
+	//	Same guarantees as the general LockFreeFixedSizeHashMap::visit
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit(F func)
+	{
+		for (size_t slot_idx = 0; slot_idx < SlotsNum; ++slot_idx)
+		{
+			if ((metas[slot_idx].load(std::memory_order_acquire) & TakenBit) == 0)
+				continue;
+
+			const Slot slot = slots[slot_idx].template load<Slot>();
+			func(std::make_pair(slot.key, slot.value));
+		}
+	}
+
+	//	retries/restarts are always zero, max_chain_length is the longest probing sequence
+	HashMapStats stats() const
+	{
+		return counters.snapshot();
+	}
+
+private:
+	template<typename CompatibleK>
+	static size_t hash_of(const CompatibleK& key)
+	{
+		if constexpr (std::is_same_v<CompatibleK, K> || requires { typename Hash::is_transparent; })
+			return Hash()(key);
+		else
+			return Hash()(static_cast<K>(key));
+	}
+
+	template<typename CompatibleK>
+	static bool keys_equal(const K& slot_key, const CompatibleK& key)
+	{
+		return KeyEqual()(slot_key, key);
+	}
+
+	template<typename CompatibleK>
+	static size_t home_slot_of(const CompatibleK& key)
+	{
+		return hashmap_policy::PowerOfTwo::index(hash_of(key), SlotsNum);
+	}
+
+	//	Writer only. Probe at which the key sits, or NoSlot.
+	template<typename CompatibleK>
+	size_t find_probe(size_t home_idx, const CompatibleK& key) const
+	{
+		for (size_t probe = 0; probe < SlotsNum; ++probe)
+		{
+			const size_t slot_idx = (home_idx + probe) & (SlotsNum - 1);
+			const uint64_t meta = metas[slot_idx].load(std::memory_order_relaxed);
+			if ((meta & TakenBit) != 0 && keys_equal(slots[slot_idx].template load<Slot>().key, key))
+				return probe;
+			if (meta < OverflowStep)
+				break;
+		}
+
+		return NoSlot;
+	}
+
+	template<bool UpdateIfFound>
+	bool write(const K& key, const V& value)
+	{
+		const size_t home_idx = home_slot_of(key);
+		const size_t found_probe = find_probe(home_idx, key);
+		if (found_probe != NoSlot)
+		{
+			//	single store, readers see either the old or the new value
+			if constexpr (UpdateIfFound)
+				slots[(home_idx + found_probe) & (SlotsNum - 1)].store(Slot{ key, value });
+			return false;
+		}
+
+		if (elems_num == MaxElems)
+		{
+			counters.overflow();
+			throw std::runtime_error("Hash map overflow");
+		}
+
+		//	key goes into the first free slot on its probing path, load factor guarantees there is one
+		size_t probe = 0;
+		while ((metas[(home_idx + probe) & (SlotsNum - 1)].load(std::memory_order_relaxed) & TakenBit) != 0)
+			++probe;
+
+		//	Slots we skipped are marked first, so the moment the key becomes visible readers are already allowed to probe that far
+		for (size_t passed = 0; passed < probe; ++passed)
+		{
+			auto& passed_meta = metas[(home_idx + passed) & (SlotsNum - 1)];
+			passed_meta.store(passed_meta.load(std::memory_order_relaxed) + OverflowStep, std::memory_order_release);
+		}
+
+		const size_t slot_idx = (home_idx + probe) & (SlotsNum - 1);
+		slots[slot_idx].store(Slot{ key, value });
+		metas[slot_idx].store(metas[slot_idx].load(std::memory_order_relaxed) | TakenBit, std::memory_order_release);
+
+		++elems_num;
+		counters.chain_length(probe + 1);
+		return true;
 	}
 
-	alignas(64) std::array<std::atomic<size_t>, BucketsNum> buckets;	//	slot marked as EmptyBucketTag - empty
-	alignas(64) std::array<Node, MaxElems> nodes;
-	alignas(64) details::FixedAllocator<MaxElems> node_allocator;
+	alignas(64) details::FixedArray<std::atomic<uint64_t>, SlotsNum> metas;
+	alignas(64) details::FixedArray<details::Atomic128, SlotsNum> slots;
+	size_t elems_num = 0;	//	writer only
+	[[no_unique_address]] StatsCounters counters;
 };
 
@@ -0,0 +1,622 @@
+#include "LockFreeFixedSizeHashmap.h"
+#include "LockFreeReplicatedHashmap.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+//	Benchmarks of the lock free hash maps, not a part of the regular test run: `STL-Helpers --bench`.
+//	Numbers make sense only for optimized builds.
+
+static std::mt19937_64 bench_gen(42);
+
+//	keeps the compiler from throwing away the reads
+static volatile uint64_t bench_sink;
+
+template<typename F>
+double ns_per_op(size_t ops, F&& body)
+{
+	auto start = std::chrono::steady_clock::now();
+	body();
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / ops;
+}
+
+//	`value` with `precision` digits after the point, right aligned to `width`
+std::string fixed(double value, int precision, int width = 0)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(precision) << std::setw(width) << value;
+	return out.str();
+}
+
+//	left aligned to `width`
+std::string pad(const std::string& text, size_t width = 60)
+{
+	return text.size() < width ? text + std::string(width - text.size(), ' ') : text;
+}
+
+void report(const std::string& name, double ns)
+{
+	std::cout << pad(name) << fixed(ns, 1, 10) << " ns/op" << fixed(1000.0 / ns, 1, 10) << " Mops/s\n";
+}
+
+//	p50/p99/p999 out of per operation latencies
+void report_percentiles(const std::string& name, std::vector<double>& ns)
+{
+	std::ranges::sort(ns);
+	auto at = [&](double quantile) { return ns[std::min(ns.size() - 1, size_t(quantile * ns.size()))]; };
+	std::cout << pad(name) << fixed(at(0.5), 0, 10) << " p50" << fixed(at(0.99), 0, 10) << " p99" << fixed(at(0.999), 0, 10) << " p999 ns\n";
+}
+
+//	-----------------------------------
+
+//	bench - read_batch against looped read(), map is way larger than caches so nearly every lookup misses
+void bench_read_batch()
+{
+	constexpr size_t c_elements_num = 2'000'000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num>;
+	auto hmap = std::make_unique<Map>();
+
+	std::vector<uint64_t> keys(c_elements_num);
+	for (auto& key : keys)
+	{
+		key = bench_gen();
+		hmap->store(key, key);
+	}
+
+	std::vector<uint64_t> lookups(1 << 20);
+	for (auto& key : lookups)
+		key = keys[bench_gen() % keys.size()];
+
+	uint64_t sum = 0;
+	report("read() loop, 2M entries", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += *hmap->read(key);
+		}));
+
+	for (size_t batch : { 16, 32, 64 })
+	{
+		std::vector<std::optional<uint64_t>> results(batch);
+		report("read_batch(" + std::to_string(batch) + "), 2M entries", ns_per_op(lookups.size(), [&] {
+			for (size_t i = 0; i + batch <= lookups.size(); i += batch)
+			{
+				hmap->read_batch(std::span(lookups).subspan(i, batch), results);
+				for (const auto& result : results)
+					sum += *result;
+			}
+			}));
+	}
+
+	bench_sink = sum;
+}
+
+//	bench - read() copying the whole 512 bytes value against read_with() taking a single field of it
+void bench_read_with()
+{
+	struct WideValue { uint64_t fields[64]; };
+	constexpr size_t c_elements_num = 200'000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, WideValue, c_elements_num>;
+	auto hmap = std::make_unique<Map>();
+
+	std::vector<uint64_t> keys(c_elements_num);
+	for (auto& key : keys)
+	{
+		key = bench_gen();
+		WideValue value;
+		std::fill(std::begin(value.fields), std::end(value.fields), key);
+		hmap->store(key, value);
+	}
+
+	std::vector<uint64_t> lookups(1 << 20);
+	for (auto& key : lookups)
+		key = keys[bench_gen() % keys.size()];
+
+	uint64_t sum = 0;
+	report("read(), 512 bytes value", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += hmap->read(key)->fields[7];
+		}));
+	report("read_with(), one field of 512 bytes value", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += *hmap->read_with(key, [](const WideValue& value) { return value.fields[7]; });
+		}));
+
+	report("visit(), 512 bytes value", ns_per_op(c_elements_num, [&] {
+		hmap->visit([&](const std::pair<uint64_t, WideValue>& keyval) { sum += keyval.second.fields[7]; });
+		}));
+	report("visit_with(), one field of 512 bytes value", ns_per_op(c_elements_num, [&] {
+		hmap->visit_with([](uint64_t, const WideValue& value) { return value.fields[7]; }, [&](uint64_t field) { sum += field; });
+		}));
+	bench_sink = sum;
+}
+
+//	bench - node layouts under contention. Writer keeps overwriting even keys at full rate, readers read only odd keys.
+//	Nodes are allocated in insertion order, so every node readers need is a neighbour of a node being written.
+template<typename Layout>
+struct BenchNodeLayoutTraits : hashmap_policy::DefaultTraits { using NodeLayout = Layout; };
+
+template<typename Layout>
+void bench_node_layout_contention(const std::string& layout_name)
+{
+	using Traits = BenchNodeLayoutTraits<Layout>;
+	constexpr size_t c_elements_num = 4096;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num, Traits>;
+	auto hmap = std::make_unique<Map>();
+	for (uint64_t key = 0; key < c_elements_num; ++key)
+		hmap->store(key, key);
+
+	const unsigned c_num_of_reading_threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+	std::atomic<bool> stop = false;
+	std::atomic<uint64_t> total_reads = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		std::jthread writer{ [&] {
+			uint64_t value = 0;
+			while (!stop.load(std::memory_order_relaxed))
+				for (uint64_t key = 0; key < c_elements_num; key += 2)
+					hmap->store(key, ++value);
+		} };
+
+		std::vector<std::jthread> readers;
+		for (unsigned i = 0; i < c_num_of_reading_threads; ++i)
+			readers.emplace_back([&, seed = i] {
+				std::mt19937_64 reader_gen(seed);
+				uint64_t reads = 0, sum = 0;
+				while (!stop.load(std::memory_order_relaxed))
+				{
+					for (int i = 0; i < 1024; ++i)
+						sum += *hmap->read(reader_gen() % (c_elements_num / 2) * 2 + 1);
+					reads += 1024;
+				}
+				total_reads += reads;
+				bench_sink = sum;
+			});
+
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		stop = true;
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+	report(layout_name + " nodes, " + std::to_string(c_num_of_reading_threads) + " readers + writer (aggregate)", elapsed.count() / total_reads);
+}
+
+//	bench - node allocators at high fill. Steady state: free a random taken node, allocate a node back.
+//	Free nodes end up scattered all over the bitmask, as they are in a long living map.
+template<typename Allocator>
+void bench_allocator_fill(const std::string& allocator_name, double fill, unsigned threads_num)
+{
+	constexpr size_t c_nodes_num = Allocator::NodesMax;
+	auto allocator = std::make_unique<Allocator>();
+
+	std::vector<size_t> taken(c_nodes_num);
+	for (auto& idx : taken)
+		idx = allocator->alloc();
+	std::ranges::shuffle(taken, bench_gen);
+
+	const size_t taken_num = size_t(c_nodes_num * fill);
+	for (size_t i = taken_num; i < c_nodes_num; ++i)
+		allocator->free(taken[i]);
+	taken.resize(taken_num);
+
+	constexpr size_t c_ops_per_thread = 1'000'000;
+	const size_t slice = taken_num / threads_num;
+	double ns = ns_per_op(c_ops_per_thread * threads_num, [&] {
+		std::vector<std::jthread> threads;
+		for (unsigned thread_idx = 0; thread_idx < threads_num; ++thread_idx)
+			threads.emplace_back([&, thread_idx] {
+				std::mt19937_64 thread_gen(thread_idx);
+				size_t* thread_taken = &taken[thread_idx * slice];
+				for (size_t i = 0; i < c_ops_per_thread; ++i)
+				{
+					size_t& idx = thread_taken[thread_gen() % slice];
+					allocator->free(idx);
+					idx = allocator->alloc();
+				}
+			});
+		});
+
+	report(allocator_name + " free+alloc, " + fixed(fill * 100, 1) + "% full, " + std::to_string(threads_num) + " thread(s)", ns);
+}
+
+
+//	bench - chain lengths the hasher produces over map buckets (same bucket count as the map), and cost of hashing itself
+template<typename Hasher>
+void bench_hash_distribution(const std::string& hasher_name)
+{
+	constexpr size_t c_elements_num = 1'000'000;
+	constexpr size_t c_buckets_num = details::next_prime(c_elements_num * 2);
+
+	const std::pair<std::string, uint64_t> patterns[] = { {"sequential", 1}, {"stride 4096", 4096}, {"stride 2^32", 1ULL << 32} };
+	for (const auto& [pattern_name, stride] : patterns)
+	{
+		std::vector<uint32_t> chains(c_buckets_num);
+		for (uint64_t i = 0; i < c_elements_num; ++i)
+			++chains[Hasher()(i * stride) % c_buckets_num];
+
+		const size_t empty = std::ranges::count(chains, 0u);
+		const uint32_t longest = std::ranges::max(chains);
+		//	average number of nodes walked to find a present key
+		double probes = 0;
+		for (uint32_t chain : chains)
+			probes += chain * (chain + 1) / 2.0;
+
+		std::cout << pad(hasher_name + ", " + pattern_name) << std::setw(10) << longest << " max chain"
+			<< fixed(100.0 * empty / c_buckets_num, 1, 10) << "% empty" << fixed(probes / c_elements_num, 2, 10) << " probes/hit\n";
+	}
+
+	uint64_t sum = 0;
+	report(hasher_name + ", hash", ns_per_op(c_elements_num, [&] {
+		for (uint64_t i = 0; i < c_elements_num; ++i)
+			sum += Hasher()(i);
+		}));
+	bench_sink = sum;
+}
+
+template<typename BucketsPolicy>
+struct BenchBucketsTraits : hashmap_policy::DefaultTraits { using Buckets = BucketsPolicy; };
+
+//	bench - read() of random present keys with different hash to bucket reductions, map is larger than caches
+template<typename BucketsPolicy>
+void bench_buckets(const std::string& policy_name, double occupancy)
+{
+	using Traits = BenchBucketsTraits<BucketsPolicy>;
+	constexpr size_t c_elements_num = 1'000'000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num, Traits>;
+	auto hmap = std::make_unique<Map>();
+
+	std::vector<uint64_t> keys(size_t(c_elements_num * occupancy));
+	for (auto& key : keys)
+	{
+		key = bench_gen();
+		hmap->store(key, key);
+	}
+
+	std::vector<uint64_t> lookups(1 << 20);
+	for (auto& key : lookups)
+		key = keys[bench_gen() % keys.size()];
+
+	uint64_t sum = 0;
+	report("read(), " + policy_name + " buckets, " + fixed(occupancy * 100, 0) + "% full", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += *hmap->read(key);
+		}));
+	bench_sink = sum;
+}
+
+template<typename ReclamationPolicy>
+struct BenchReclamationTraits : hashmap_policy::DefaultTraits { using Reclamation = ReclamationPolicy; };
+
+//	bench - read latency tails under the churn of test_visit_in_noise: writer keeps removing random keys and inserting new ones,
+//	readers look up keys which are always there. Removed nodes reused right away derail readers standing on them.
+template<typename ReclamationPolicy>
+void bench_reclamation_tail_latency(const std::string& reclamation_name)
+{
+	using Traits = BenchReclamationTraits<ReclamationPolicy>;
+	constexpr size_t c_elements_num = 1000;
+	using Map = LockFreeFixedSizeHashMap<int, int, c_elements_num + 100, Traits>;
+	auto hmap = std::make_unique<Map>();
+	for (int i = -100; i <= -1; ++i)
+		hmap->store(i, i);
+
+	const unsigned c_num_of_reading_threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+	constexpr size_t c_reads_per_thread = 1 << 20;
+	std::atomic<bool> stop = false;
+	std::vector<std::vector<double>> latencies(c_num_of_reading_threads);
+	{
+		std::jthread writer{ [&] {
+			std::mt19937 writer_gen(1);
+			std::vector<int> inserted;
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				if (inserted.size() == c_elements_num)
+				{
+					size_t idx_to_remove = writer_gen() % c_elements_num;
+					hmap->remove(inserted[idx_to_remove]);
+					inserted[idx_to_remove] = inserted.back();
+					inserted.pop_back();
+				}
+
+				int num = int(writer_gen() % 1000) + 1;
+				hmap->store(num, num);
+				inserted.push_back(num);
+			}
+		} };
+
+		std::vector<std::jthread> readers;
+		for (unsigned i = 0; i < c_num_of_reading_threads; ++i)
+			readers.emplace_back([&, thread_idx = i] {
+				auto& thread_latencies = latencies[thread_idx];
+				thread_latencies.reserve(c_reads_per_thread);
+				uint64_t sum = 0;
+				for (size_t repeat = 0; repeat < c_reads_per_thread; ++repeat)
+				{
+					auto start = std::chrono::steady_clock::now();
+					sum += *hmap->read(-1 - int(repeat % 100));
+					std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+					thread_latencies.push_back(elapsed.count());
+				}
+				bench_sink = sum;
+			});
+
+		readers.clear();
+		stop = true;
+	}
+
+	std::vector<double> all;
+	for (auto& thread_latencies : latencies)
+		all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+	report_percentiles("read() under churn, " + reclamation_name, all);
+}
+
+//	bench - initial fill of an empty map, bulk_load against looped store(), then lookups over the filled map
+void bench_bulk_load()
+{
+	constexpr size_t c_elements_num = 4'000'000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num>;
+
+	std::vector<std::pair<uint64_t, uint64_t>> items(c_elements_num);
+	for (auto& [key, value] : items)
+		key = value = bench_gen();
+
+	std::vector<uint64_t> lookups(1 << 20);
+	for (auto& key : lookups)
+		key = items[bench_gen() % items.size()].first;
+
+	auto stored = std::make_unique<Map>();
+	report("looped store(), per key", ns_per_op(items.size(), [&] {
+		for (const auto& [key, value] : items)
+			stored->store(key, uint64_t(value));
+		}));
+
+	auto loaded = std::make_unique<Map>();
+	report("bulk_load(), per key", ns_per_op(items.size(), [&] { loaded->bulk_load(items); }));
+
+	uint64_t sum = 0;
+	report("read() after looped store()", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += *stored->read(key);
+		}));
+	report("read() after bulk_load()", ns_per_op(lookups.size(), [&] {
+		for (uint64_t key : lookups)
+			sum += *loaded->read(key);
+		}));
+	bench_sink = sum;
+}
+
+//	bench - batches of overwrites (a few new keys among them) applied by store_batch against looped store(),
+//	with the map fitting into the cache and with the one way larger
+template<size_t ElementsNum>
+void bench_store_batch()
+{
+	constexpr size_t c_batch_size = 1000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, ElementsNum>;
+
+	auto looped = std::make_unique<Map>();
+	auto batched = std::make_unique<Map>();
+	for (uint64_t key = 0; key < ElementsNum / 2; ++key)
+	{
+		looped->store(key, uint64_t(key));
+		batched->store(key, uint64_t(key));
+	}
+
+	std::vector<std::pair<uint64_t, uint64_t>> updates(1 << 22);
+	for (auto& [key, value] : updates)
+	{
+		key = bench_gen() % (ElementsNum / 2 + ElementsNum / 100);
+		value = bench_gen();
+	}
+
+	report("store() looped, " + std::to_string(ElementsNum) + " elements", ns_per_op(updates.size(), [&] {
+		for (const auto& [key, value] : updates)
+			looped->store(key, uint64_t(value));
+		}));
+	report("store_batch() of " + std::to_string(c_batch_size) + ", " + std::to_string(ElementsNum) + " elements", ns_per_op(updates.size(), [&] {
+		for (size_t batch_start = 0; batch_start < updates.size(); batch_start += c_batch_size)
+			batched->store_batch(std::span(updates).subspan(batch_start, std::min(c_batch_size, updates.size() - batch_start)));
+		}));
+}
+
+//	bench - ordered reads of a million keys: visit() with copying out and sorting against the sorted index,
+//	for the whole map and for a range of 1000 keys
+void bench_sorted_index()
+{
+	struct Traits : hashmap_policy::DefaultTraits { using Index = hashmap_policy::SkipListIndex<>; };
+	constexpr size_t c_elements_num = 1 << 20;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num, Traits>;
+	auto hmap = std::make_unique<Map>();
+	for (size_t i = 0; i < c_elements_num; ++i)
+		hmap->store(bench_gen() % (c_elements_num * 4), uint64_t(i));
+
+	constexpr uint64_t c_range_lo = c_elements_num, c_range_hi = c_range_lo + 4000;
+	auto copy_and_sort = [&](uint64_t lo, uint64_t hi) {
+		std::vector<std::pair<uint64_t, uint64_t>> items;
+		hmap->visit([&](const std::pair<uint64_t, uint64_t>& item) {
+			if (item.first >= lo && item.first <= hi)
+				items.push_back(item);
+		});
+		std::ranges::sort(items);
+		return items.size();
+	};
+
+	size_t items_num = 0;
+	report("all keys, visit() + sort (per key)", ns_per_op(c_elements_num, [&] { items_num = copy_and_sort(0, c_elements_num * 4); }));
+	report("all keys, visit_sorted() (per key)", ns_per_op(c_elements_num, [&] {
+		hmap->visit_sorted([&](const std::pair<uint64_t, uint64_t>& item) { bench_sink = item.second; });
+		}));
+
+	report("range of ~1000 keys, visit() + filter + sort (per scan)", ns_per_op(1, [&] { items_num = copy_and_sort(c_range_lo, c_range_hi); }));
+	report("range of ~1000 keys, visit_range() (per scan)", ns_per_op(100, [&] {
+		for (int repeat = 0; repeat < 100; ++repeat)
+			hmap->visit_range(c_range_lo, c_range_hi, [&](const std::pair<uint64_t, uint64_t>& item) { bench_sink = item.second; });
+		}));
+	bench_sink = items_num;
+}
+
+//	bench - aggregation of counters, upsert() against read() followed by store()
+void bench_upsert()
+{
+	constexpr size_t c_elements_num = 100'000;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num>;
+	auto hmap = std::make_unique<Map>();
+
+	std::vector<uint64_t> keys(c_elements_num / 2);
+	for (auto& key : keys)
+		key = bench_gen();
+
+	std::vector<uint64_t> updates(1 << 22);
+	for (auto& key : updates)
+		key = keys[bench_gen() % keys.size()];
+
+	report("read() + store() of a counter", ns_per_op(updates.size(), [&] {
+		for (uint64_t key : updates)
+			hmap->store(key, hmap->read(key).value_or(0) + 1);
+		}));
+	report("upsert() of a counter", ns_per_op(updates.size(), [&] {
+		for (uint64_t key : updates)
+			hmap->upsert(key, [](uint64_t& value) { ++value; });
+		}));
+}
+
+template<typename Layout>
+struct BenchSmallValuesTraits : hashmap_policy::DefaultTraits
+{
+	using NodeLayout = Layout;
+	using Stats = hashmap_policy::CountingStats;
+};
+
+//	bench - read latency of small key/value pairs under a writer overwriting the same keys nonstop,
+//	seqlock nodes (readers retry when they hit a node being written) against atomic 16 byte slots (single load, no retries)
+template<typename Layout>
+void bench_small_values_under_writer(const std::string& layout_name)
+{
+	using Traits = BenchSmallValuesTraits<Layout>;
+	constexpr size_t c_elements_num = 64;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num, Traits>;
+	auto hmap = std::make_unique<Map>();
+	for (uint64_t key = 0; key < c_elements_num; ++key)
+		hmap->store(key, uint64_t(key));
+
+	const unsigned c_num_of_reading_threads = std::max(1u, std::thread::hardware_concurrency() - 1);
+	constexpr size_t c_reads_per_thread = 1 << 20;
+	std::atomic<bool> stop = false;
+	std::vector<std::vector<double>> latencies(c_num_of_reading_threads);
+	{
+		std::jthread writer{ [&] {
+			for (uint64_t repeat = 0; !stop.load(std::memory_order_relaxed); ++repeat)
+				hmap->store(repeat % c_elements_num, uint64_t(repeat));
+		} };
+
+		std::vector<std::jthread> readers;
+		for (unsigned i = 0; i < c_num_of_reading_threads; ++i)
+			readers.emplace_back([&, thread_idx = i] {
+				auto& thread_latencies = latencies[thread_idx];
+				thread_latencies.reserve(c_reads_per_thread);
+				uint64_t sum = 0;
+				for (size_t repeat = 0; repeat < c_reads_per_thread; ++repeat)
+				{
+					auto start = std::chrono::steady_clock::now();
+					sum += *hmap->read(repeat % c_elements_num);
+					std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+					thread_latencies.push_back(elapsed.count());
+				}
+				bench_sink = sum;
+			});
+
+		readers.clear();
+		stop = true;
+	}
+
+	std::vector<double> all;
+	for (auto& thread_latencies : latencies)
+		all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+	report_percentiles("read() under saturating writer, " + layout_name, all);
+	std::cout << pad("") << fixed(double(hmap->stats().retries) / all.size(), 4, 10) << " retries/read\n";
+}
+
+//	bench - readers pinned to every NUMA node, reading their node's replica against the replica of another node.
+//	Replicas are larger than caches, so reads go to memory. Single node box has nothing remote to compare with.
+void bench_numa_replicas()
+{
+	constexpr size_t c_elements_num = 1 << 20;
+	using Map = LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_elements_num>;
+	NumaReplicatedHashMap<Map> hmap;
+	for (uint64_t key = 0; key < c_elements_num; ++key)
+		hmap.store(key, uint64_t(key));
+
+	details::NumaTopology topology;
+	const size_t replicas_num = hmap.replicas_num();
+	if (replicas_num == 1)
+		std::cout << "single NUMA node, local and remote replica are the same\n";
+
+	constexpr size_t c_reads_per_thread = 1 << 22;
+	for (size_t node = 0; node < topology.nodes_num(); ++node)
+	{
+		for (bool local : { true, false })
+		{
+			double ns = 0;
+			std::jthread([&] {
+				topology.pin_current_thread(node);
+				const size_t replica_idx = local ? hmap.local_replica_idx() : (hmap.local_replica_idx() + 1) % replicas_num;
+				Map& replica = hmap.replica(replica_idx);
+				std::vector<uint64_t> keys(c_reads_per_thread);
+				for (auto& key : keys)
+					key = bench_gen() % c_elements_num;
+
+				uint64_t sum = 0;
+				ns = ns_per_op(keys.size(), [&] {
+					for (uint64_t key : keys)
+						sum += *replica.read(key);
+				});
+				bench_sink = sum;
+			}).join();
+			report("read(), readers on node " + std::to_string(node) + ", " + (local ? "local" : "remote") + " replica", ns);
+		}
+	}
+}
+
+void lock_free_hash_map_benchmarks()
+{
+	bench_read_batch();
+	bench_read_with();
+	bench_bulk_load();
+	bench_upsert();
+	bench_store_batch<1 << 14>();
+	bench_store_batch<1 << 20>();
+	bench_sorted_index();
+	bench_node_layout_contention<hashmap_policy::PackedNodes>("packed");
+	bench_node_layout_contention<hashmap_policy::AlignedNodes>("aligned");
+	bench_node_layout_contention<hashmap_policy::SplitNodes>("split");
+	bench_small_values_under_writer<hashmap_policy::PackedNodes>("packed nodes");
+	bench_small_values_under_writer<hashmap_policy::AtomicSlots>("atomic slots");
+	bench_numa_replicas();
+
+	for (double occupancy : { 0.5, 0.9 })
+	{
+		bench_buckets<hashmap_policy::PrimeModulo>("prime modulo", occupancy);
+		bench_buckets<hashmap_policy::PrimeFastRange>("prime fastrange", occupancy);
+		bench_buckets<hashmap_policy::PowerOfTwo>("power of 2", occupancy);
+	}
+
+	bench_reclamation_tail_latency<hashmap_policy::ImmediateReuse>("immediate reuse");
+	bench_reclamation_tail_latency<hashmap_policy::EpochReclamation<>>("epoch reclamation");
+
+	bench_hash_distribution<std::hash<uint64_t>>("std::hash");
+	bench_hash_distribution<hashmap_policy::IntegerMixHash>("IntegerMixHash");
+	bench_hash_distribution<hashmap_policy::WyHash>("WyHash");
+
+	constexpr size_t c_allocator_nodes = 1 << 20;
+	for (double fill : { 0.9, 0.99, 0.999 })
+	{
+		bench_allocator_fill<details::FixedAllocator<c_allocator_nodes>>("FixedAllocator", fill, 1);
+		bench_allocator_fill<details::ConcurrentFixedAllocator<c_allocator_nodes>>("ConcurrentFixedAllocator", fill, 1);
+		bench_allocator_fill<details::ConcurrentFixedAllocator<c_allocator_nodes>>("ConcurrentFixedAllocator", fill, std::max(2u, std::thread::hardware_concurrency()));
+	}
+}
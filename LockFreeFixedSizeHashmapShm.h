@@ -0,0 +1,148 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>	//	already included by LockFreeFixedSizeHashmap.h, min/max macros off
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+* Named shared memory segment holding LockFreeFixedSizeHashMap. Typical setup is one writer process and many readers:
+*  - create(name) - writer, makes a new segment and constructs the map inside (throws if segment already exists)
+*  - open(name)   - reader, maps existing segment and validates its layout (throws on mismatch)
+*  - unlink(name) - removes the name, segment memory lives until the last process unmaps it (no-op on Windows,
+*                   where segment is gone together with its last handle)
+*
+* Usage:
+*	auto writer = SharedMemoryHashMap<LockFreeFixedSizeHashMap<int, Quote, 1000>>::create("/quotes");
+*	writer->store(key, quote);
+*	...
+*	auto reader = SharedMemoryHashMap<LockFreeFixedSizeHashMap<int, Quote, 1000>>::open("/quotes");
+*	std::optional<Quote> quote = reader->read(key);
+*/
+
+template<typename Map>
+class SharedMemoryHashMap
+{
+public:
+	static SharedMemoryHashMap create(const std::string& name)
+	{
+		SharedMemoryHashMap segment;
+		segment.map_segment(name, Map::shared_memory_size(), true);
+		segment.map = Map::create_in(segment.memory, segment.size);
+		return segment;
+	}
+
+	static SharedMemoryHashMap open(const std::string& name)
+	{
+		SharedMemoryHashMap segment;
+		segment.map_segment(name, 0, false);
+		segment.map = Map::attach_to(segment.memory, segment.size);
+		return segment;
+	}
+
+	static void unlink(const std::string& name)
+	{
+#if !defined(_WIN32)
+		shm_unlink(name.c_str());
+#endif
+	}
+
+	SharedMemoryHashMap(SharedMemoryHashMap&& other) noexcept { swap(other); }
+	SharedMemoryHashMap& operator=(SharedMemoryHashMap&& other) noexcept { swap(other); return *this; }
+	SharedMemoryHashMap(const SharedMemoryHashMap&) = delete;
+	SharedMemoryHashMap& operator=(const SharedMemoryHashMap&) = delete;
+
+	~SharedMemoryHashMap()
+	{
+		//	map itself is not destroyed - it belongs to the segment, not to this process
+#if defined(_WIN32)
+		if (memory)
+			UnmapViewOfFile(memory);
+		if (handle)
+			CloseHandle(handle);
+#else
+		if (memory)
+			munmap(memory, size);
+#endif
+	}
+
+	Map* get() const { return map; }
+	Map* operator->() const { return map; }
+	Map& operator*() const { return *map; }
+
+private:
+	SharedMemoryHashMap() = default;
+
+	void swap(SharedMemoryHashMap& other) noexcept
+	{
+		std::swap(memory, other.memory);
+		std::swap(size, other.size);
+		std::swap(map, other.map);
+#if defined(_WIN32)
+		std::swap(handle, other.handle);
+#endif
+	}
+
+	//	`create_size` is used only when creating, otherwise size is taken from the existing segment
+	void map_segment(const std::string& name, size_t create_size, bool create)
+	{
+#if defined(_WIN32)
+		if (create)
+		{
+			const uint64_t size64 = create_size;
+			handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, DWORD(size64 >> 32), DWORD(size64), name.c_str());
+			if (handle && GetLastError() == ERROR_ALREADY_EXISTS)
+				throw std::runtime_error("Shared memory: segment already exists " + name);
+		}
+		else
+			handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+
+		if (!handle)
+			throw std::runtime_error("Shared memory: cannot open segment " + name);
+
+		memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if (!memory)
+			throw std::runtime_error("Shared memory: cannot map segment " + name);
+
+		MEMORY_BASIC_INFORMATION info = {};
+		VirtualQuery(memory, &info, sizeof(info));
+		size = create ? create_size : info.RegionSize;
+#else
+		int fd = shm_open(name.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0666);
+		if (fd < 0)
+			throw std::runtime_error("Shared memory: cannot open segment " + name);
+
+		struct stat st = {};
+		bool sized = create ? ftruncate(fd, off_t(create_size)) == 0 : fstat(fd, &st) == 0;
+		size_t mapped_size = create ? create_size : size_t(st.st_size);
+		void* mem = sized ? mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+		close(fd);
+
+		if (mem == MAP_FAILED)
+		{
+			if (create)
+				shm_unlink(name.c_str());
+			throw std::runtime_error("Shared memory: cannot map segment " + name);
+		}
+
+		memory = mem;
+		size = mapped_size;
+#endif
+	}
+
+	void* memory = nullptr;
+	size_t size = 0;
+	Map* map = nullptr;
+#if defined(_WIN32)
+	HANDLE handle = nullptr;
+#endif
+};
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <span>
+#include <string>
+#include <cstring>
+#include <concepts>
+#include <ranges>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>	//	already included by LockFreeFixedSizeHashmap.h, min/max macros off
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*
+* Snapshot files of LockFreeFixedSizeHashMap, for checkpoints and warm restarts:
+*  - save_snapshot(map, path) - takes a consistent map.snapshot() and writes it into `path` through a temporary file,
+*                               synced to the disk before it replaces `path` (and the directory synced after), so `path`
+*                               holds either the previous or the new complete snapshot, OS crash included
+*  - load_snapshot(map, path) - maps the file and bulk loads its records into a fresh `map`, returns number of records
+*  - SnapshotFile<K, V>       - read only mapping of a snapshot file, records can be used in place
+*
+* File is a header followed by a flat array of {key, value} records, sorted by key: operator< if K has one, byte order
+* of the key otherwise. Unlike a hash order it's the same for every build, so files can be binary searched and diffed.
+* Keys and values are written as is (trivially copyable), so the file is readable only by a build with the same K/V layout -
+* header checks that.
+*
+* Usage:
+*	save_snapshot(quotes, "quotes.snap");
+*	...
+*	LockFreeFixedSizeHashMap<int, Quote, 1000> restored;
+*	load_snapshot(restored, "quotes.snap");
+*/
+
+namespace details {
+	struct SnapshotFileHeader
+	{
+		static constexpr uint64_t Magic = 0x50414E535346464CULL;	//	"LFFSSNAP"
+		static constexpr uint32_t FormatVersion = 2;				//	bump on any change of the header/record layout
+
+		uint64_t magic = Magic;
+		uint32_t format_version = FormatVersion;
+		uint32_t records_offset = 0;	//	records start here, aligned for the record type
+		uint64_t key_size = 0;
+		uint64_t value_size = 0;
+		uint64_t record_size = 0;
+		uint64_t records_num = 0;
+		uint64_t generation = 0;		//	Snapshot::generation of the map the file was taken from
+	};
+
+	template<typename K, typename V>
+	struct SnapshotRecord
+	{
+		K key;
+		V value;
+	};
+
+	//	Order of the snapshot records
+	template<typename K>
+	bool snapshot_key_less(const K& a, const K& b)
+	{
+		if constexpr (std::totally_ordered<K>)
+			return a < b;
+		else
+			return std::memcmp(&a, &b, sizeof(K)) < 0;
+	}
+
+	//	Flushes the file content down to the storage device
+	inline void sync_file(const std::string& path)
+	{
+#if defined(_WIN32)
+		HANDLE handle = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		const bool synced = handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle);
+		if (handle != INVALID_HANDLE_VALUE)
+			CloseHandle(handle);
+#else
+		const int fd = ::open(path.c_str(), O_WRONLY);
+		const bool synced = fd >= 0 && fsync(fd) == 0;
+		if (fd >= 0)
+			close(fd);
+#endif
+		if (!synced)
+			throw std::runtime_error("Snapshot: cannot sync file " + path);
+	}
+
+	//	Replaces `to` with `from` and makes the replacement itself durable: POSIX rename lives in the directory entry,
+	//	which is synced separately, Windows does it as part of the move with write through.
+	inline void replace_file(const std::string& from, const std::string& to)
+	{
+#if defined(_WIN32)
+		if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+			throw std::runtime_error("Snapshot: cannot replace file " + to);
+#else
+		std::filesystem::rename(from, to);
+
+		std::filesystem::path directory = std::filesystem::path(to).parent_path();
+		if (directory.empty())
+			directory = ".";
+		const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+		const bool synced = fd >= 0 && fsync(fd) == 0;
+		if (fd >= 0)
+			close(fd);
+		if (!synced)
+			throw std::runtime_error("Snapshot: cannot sync directory of " + to);
+#endif
+	}
+
+	template<typename K, typename V>
+	constexpr size_t snapshot_records_offset()
+	{
+		constexpr size_t alignment = std::max<size_t>(alignof(SnapshotRecord<K, V>), 64);
+		return (sizeof(SnapshotFileHeader) + alignment - 1) / alignment * alignment;
+	}
+}
+
+
+template<typename K, typename V>
+class SnapshotFile
+{
+public:
+	using Record = details::SnapshotRecord<K, V>;
+
+	//	Maps the file read only and validates its header (throws on mismatch)
+	static SnapshotFile open(const std::string& path)
+	{
+		SnapshotFile file;
+		file.map_file(path);
+
+		if (file.size < sizeof(details::SnapshotFileHeader))
+			throw std::runtime_error("Snapshot: file is too small for the header " + path);
+
+		const auto& header = file.header();
+		if (header.magic != details::SnapshotFileHeader::Magic)
+			throw std::runtime_error("Snapshot: not a snapshot file " + path);
+		if (header.format_version != details::SnapshotFileHeader::FormatVersion ||
+			header.records_offset != details::snapshot_records_offset<K, V>() ||
+			header.key_size != sizeof(K) ||
+			header.value_size != sizeof(V) ||
+			header.record_size != sizeof(Record))
+			throw std::runtime_error("Snapshot: layout mismatch " + path);
+		if (file.size < header.records_offset + header.records_num * sizeof(Record))
+			throw std::runtime_error("Snapshot: file is truncated " + path);
+
+		return file;
+	}
+
+	SnapshotFile(SnapshotFile&& other) noexcept { swap(other); }
+	SnapshotFile& operator=(SnapshotFile&& other) noexcept { swap(other); return *this; }
+	SnapshotFile(const SnapshotFile&) = delete;
+	SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+	~SnapshotFile()
+	{
+#if defined(_WIN32)
+		if (memory)
+			UnmapViewOfFile(memory);
+		if (mapping)
+			CloseHandle(mapping);
+		if (handle != INVALID_HANDLE_VALUE)
+			CloseHandle(handle);
+#else
+		if (memory)
+			munmap(memory, size);
+#endif
+	}
+
+	const details::SnapshotFileHeader& header() const
+	{
+		return *static_cast<const details::SnapshotFileHeader*>(memory);
+	}
+
+	//	sorted by key, see details::snapshot_key_less
+	std::span<const Record> records() const
+	{
+		const auto* first = reinterpret_cast<const Record*>(static_cast<const std::byte*>(memory) + header().records_offset);
+		return std::span<const Record>(first, header().records_num);
+	}
+
+private:
+	SnapshotFile() = default;
+
+	void swap(SnapshotFile& other) noexcept
+	{
+		std::swap(memory, other.memory);
+		std::swap(size, other.size);
+#if defined(_WIN32)
+		std::swap(handle, other.handle);
+		std::swap(mapping, other.mapping);
+#endif
+	}
+
+	void map_file(const std::string& path)
+	{
+#if defined(_WIN32)
+		handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Snapshot: cannot open file " + path);
+
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(handle, &file_size))
+			throw std::runtime_error("Snapshot: cannot open file " + path);
+		size = size_t(file_size.QuadPart);
+		if (size == 0)
+			return;
+
+		mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+			throw std::runtime_error("Snapshot: cannot map file " + path);
+
+		memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!memory)
+			throw std::runtime_error("Snapshot: cannot map file " + path);
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("Snapshot: cannot open file " + path);
+
+		struct stat st = {};
+		if (fstat(fd, &st) != 0)
+		{
+			close(fd);
+			throw std::runtime_error("Snapshot: cannot open file " + path);
+		}
+
+		size = size_t(st.st_size);
+		void* mem = size != 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+		close(fd);
+
+		if (mem == MAP_FAILED)
+			throw std::runtime_error("Snapshot: cannot map file " + path);
+
+		memory = mem;
+#endif
+	}
+
+	void* memory = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	HANDLE handle = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+
+
+//	Reader side of the map, writes may go on meanwhile (see LockFreeFixedSizeHashMap::snapshot).
+//	Returns generation of the saved snapshot, throws if writes kept spoiling every snapshot attempt.
+template<typename Map>
+size_t save_snapshot(Map& map, const std::string& path)
+{
+	using K = typename Map::key_type;
+	using V = typename Map::mapped_type;
+	using Record = details::SnapshotRecord<K, V>;
+
+	auto snapshot = map.snapshot();
+	if (!snapshot)
+		throw std::runtime_error("Snapshot: map kept changing, no consistent copy taken for " + path);
+
+	std::vector<Record> records;
+	records.reserve(snapshot->items.size());
+	for (const auto& [key, value] : snapshot->items)
+		records.push_back(Record{ key, value });
+	std::sort(records.begin(), records.end(), [](const Record& a, const Record& b) { return details::snapshot_key_less(a.key, b.key); });
+
+	details::SnapshotFileHeader header;
+	header.records_offset = static_cast<uint32_t>(details::snapshot_records_offset<K, V>());
+	header.key_size = sizeof(K);
+	header.value_size = sizeof(V);
+	header.record_size = sizeof(Record);
+	header.records_num = records.size();
+	header.generation = snapshot->generation;
+
+	const std::string temp_path = path + ".tmp";
+	{
+		std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+		const std::vector<char> padding(header.records_offset - sizeof(header), 0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(padding.data(), std::streamsize(padding.size()));
+		out.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(Record)));
+		out.flush();
+		if (!out)
+			throw std::runtime_error("Snapshot: cannot write file " + temp_path);
+	}
+
+	details::sync_file(temp_path);
+	details::replace_file(temp_path, path);
+	return snapshot->generation;
+}
+
+//	Writer side, bulk loads the records into a freshly constructed `map` (see LockFreeFixedSizeHashMap::bulk_load)
+template<typename Map>
+size_t load_snapshot(Map& map, const std::string& path)
+{
+	using K = typename Map::key_type;
+	using V = typename Map::mapped_type;
+	using Record = details::SnapshotRecord<K, V>;
+
+	const auto file = SnapshotFile<K, V>::open(path);
+	map.bulk_load(file.records() | std::views::transform([](const Record& record) { return std::pair<const K&, const V&>(record.key, record.value); }));
+	return file.records().size();
+}
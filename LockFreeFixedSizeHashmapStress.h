@@ -0,0 +1,410 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <map>
+#include <set>
+#include <mutex>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <functional>
+#include <condition_variable>
+
+/*
+* Deterministic concurrency testing of LockFreeFixedSizeHashMap, and of changes to its seqlock protocol:
+*  - Map under test is built with hashmap_policy::SchedulePointHook, its operations call back at every step of the protocol
+*  - DeterministicScheduler runs threads of a scenario one at a time: threads are real, but only one of them moves
+*    between two schedule points, the scheduler decides which one. Schedules are either
+*      random  - seeded, any failing schedule is replayed by its seed
+*      bounded - every schedule with at most N preemptions (switches away from a thread which could go on),
+*                the way CHESS does it. Most of the protocol bugs need one or two.
+*    A thread about to retry (SchedulePoint::Retry) always gives way, so spinning readers let the writer finish.
+*  - LinearizabilityHistory records calls and returns of store/remove/read, check() searches for an order of them
+*    consistent with real time in which every call returns what a plain std::map would have returned
+*
+* Usage:
+*	struct StressTraits : hashmap_policy::DefaultTraits { using Schedule = hashmap_policy::SchedulePointHook; };
+*	using Map = LockFreeFixedSizeHashMap<int, int, 16, StressTraits>;
+*
+*	DeterministicScheduler scheduler;
+*	scheduler.explore_random(100, seed, [&](DeterministicScheduler& schedule) {
+*		Map map;
+*		LinearizabilityHistory<int, int> history;
+*		schedule.run({ [&] { history.store(map, 1, 10); }, [&] { history.read(map, 1); } });
+*		history.check();
+*	});
+*
+* Failure is reported as std::runtime_error, with the seed (or the choices) of the schedule it happened in.
+*/
+
+class DeterministicScheduler
+{
+	static constexpr size_t NoThread = std::numeric_limits<size_t>::max();
+
+public:
+	using Thread = std::function<void()>;
+
+	//	Schedule longer than `max_steps` is reported as a livelock
+	explicit DeterministicScheduler(size_t max_steps = 100000) : max_steps(max_steps) {}
+
+	DeterministicScheduler(const DeterministicScheduler&) = delete;
+	DeterministicScheduler& operator=(const DeterministicScheduler&) = delete;
+
+	//	Runs `scenario(scheduler)` under `schedules_num` random schedules, seeded `seed`, `seed + 1`, ...
+	template<typename Scenario>
+	void explore_random(size_t schedules_num, uint64_t seed, Scenario&& scenario)
+	{
+		for (size_t schedule_idx = 0; schedule_idx < schedules_num; ++schedule_idx)
+		{
+			mode = Mode::Random;
+			random.seed(seed + schedule_idx);
+			preemptions_bound = std::numeric_limits<size_t>::max();
+			run_scenario(scenario, "seed " + std::to_string(seed + schedule_idx));
+		}
+	}
+
+	//	Runs `scenario(scheduler)` under every schedule with at most `preemptions` preemptions, depth first.
+	//	Stops after `max_schedules`, returns number of schedules run (less than max_schedules - all of them were tried).
+	template<typename Scenario>
+	size_t explore_bounded(size_t preemptions, size_t max_schedules, Scenario&& scenario)
+	{
+		mode = Mode::Bounded;
+		preemptions_bound = preemptions;
+		forced.clear();
+		for (size_t schedule_idx = 0; schedule_idx < max_schedules; ++schedule_idx)
+		{
+			run_scenario(scenario, "choices");
+
+			//	next schedule: last choice which still has untried alternatives, moved to the next one
+			while (!trace.empty() && trace.back().chosen + 1 == trace.back().choices_num)
+				trace.pop_back();
+			if (trace.empty())
+				return schedule_idx + 1;
+
+			forced.clear();
+			for (const Choice& choice : trace)
+				forced.push_back(choice.chosen);
+			++forced.back();
+		}
+		return max_schedules;
+	}
+
+	//	Called by the scenario: runs `threads` to completion under the current schedule.
+	//	Exception thrown by any of the threads is rethrown once all of them are done.
+	void run(const std::vector<Thread>& threads)
+	{
+		threads_num = threads.size();
+		finished.assign(threads_num, false);
+		running = NoThread;
+		steps = 0;
+		preemptions = 0;
+		livelocked = false;
+		trace.clear();
+		error = nullptr;
+
+		std::vector<Worker> workers(threads_num);
+		{
+			std::vector<std::jthread> os_threads;
+			for (size_t thread_idx = 0; thread_idx < threads_num; ++thread_idx)
+			{
+				workers[thread_idx] = Worker{ this, thread_idx };
+				os_threads.emplace_back([this, &threads, worker = &workers[thread_idx]] { work(*worker, threads[worker->thread_idx]); });
+			}
+
+			std::unique_lock lock(mutex);
+			running = choose(NoThread, true);
+			turn.notify_all();
+			turn.wait(lock, [&] { return running == NoThread; });
+		}
+
+		if (error)
+			std::rethrow_exception(error);
+		if (livelocked)
+			throw std::runtime_error("Deterministic scheduler: schedule is longer than " + std::to_string(max_steps) + " steps, livelock");
+	}
+
+private:
+	enum class Mode { Random, Bounded };
+
+	struct Worker
+	{
+		DeterministicScheduler* scheduler = nullptr;
+		size_t thread_idx = 0;
+	};
+
+	//	choice point of the schedule: `chosen` out of `choices_num` runnable threads
+	struct Choice
+	{
+		size_t chosen;
+		size_t choices_num;
+	};
+
+	template<typename Scenario>
+	void run_scenario(Scenario& scenario, std::string schedule)
+	{
+		try
+		{
+			scenario(*this);
+		}
+		catch (const std::exception& e)
+		{
+			if (mode == Mode::Bounded)
+				for (const Choice& choice : trace)
+					schedule += " " + std::to_string(choice.chosen);
+			throw std::runtime_error(std::string(e.what()) + " (schedule " + schedule + ")");
+		}
+	}
+
+	void work(Worker& worker, const Thread& thread)
+	{
+		hashmap_policy::SchedulePointHook::attach(&on_point, &worker);
+		{
+			std::unique_lock lock(mutex);
+			turn.wait(lock, [&] { return running == worker.thread_idx; });
+		}
+
+		try
+		{
+			thread();
+		}
+		catch (...)
+		{
+			std::lock_guard lock(mutex);
+			if (!error)
+				error = std::current_exception();
+		}
+		hashmap_policy::SchedulePointHook::attach(nullptr, nullptr);
+
+		std::lock_guard lock(mutex);
+		finished[worker.thread_idx] = true;
+		running = choose(worker.thread_idx, true);
+		turn.notify_all();
+	}
+
+	static void on_point(void* context, hashmap_policy::SchedulePoint point)
+	{
+		const Worker& worker = *static_cast<const Worker*>(context);
+		worker.scheduler->switch_at(worker.thread_idx, point == hashmap_policy::SchedulePoint::Retry);
+	}
+
+	void switch_at(size_t thread_idx, bool give_way)
+	{
+		std::unique_lock lock(mutex);
+		const size_t next = choose(thread_idx, give_way);
+		if (next == thread_idx)
+			return;
+
+		running = next;
+		turn.notify_all();
+		turn.wait(lock, [&] { return running == thread_idx; });
+	}
+
+	//	Thread to run next, `current` has just reached a point (NoThread at start). Under mutex.
+	size_t choose(size_t current, bool give_way)
+	{
+		const bool current_runnable = current != NoThread && !finished[current];
+		std::vector<size_t> others;
+		for (size_t thread_idx = 0; thread_idx < threads_num; ++thread_idx)
+			if (thread_idx != current && !finished[thread_idx])
+				others.push_back(thread_idx);
+
+		if (++steps > max_steps)
+		{
+			//	round robin from now on, until everybody is done
+			livelocked = true;
+			return !others.empty() ? others[0] : current_runnable ? current : NoThread;
+		}
+
+		std::vector<size_t> choices;
+		const bool preemptive = current_runnable && !give_way;
+		if (preemptive || (current_runnable && others.empty()))
+			choices.push_back(current);
+		if (!preemptive || preemptions < preemptions_bound)
+			choices.insert(choices.end(), others.begin(), others.end());
+
+		if (choices.empty())
+			return NoThread;
+		if (choices.size() == 1)
+			return choices[0];
+
+		size_t chosen = 0;
+		if (mode == Mode::Random)
+			chosen = size_t(random() % choices.size());
+		else if (trace.size() < forced.size())
+			chosen = forced[trace.size()];
+		trace.push_back(Choice{ chosen, choices.size() });
+
+		if (preemptive && chosen != 0)
+			++preemptions;
+		return choices[chosen];
+	}
+
+	const size_t max_steps;
+	Mode mode = Mode::Random;
+	std::mt19937_64 random;
+	size_t preemptions_bound = 0;
+	std::vector<size_t> forced;	//	choices the bounded schedule starts with
+
+	//	current schedule, guarded by mutex
+	std::mutex mutex;
+	std::condition_variable turn;
+	size_t threads_num = 0;
+	std::vector<bool> finished;
+	size_t running = NoThread;
+	size_t steps = 0;
+	size_t preemptions = 0;
+	bool livelocked = false;
+	std::vector<Choice> trace;
+	std::exception_ptr error;
+};
+
+
+//	Calls and returns of map operations, checked against a sequential std::map
+template<typename K, typename V>
+class LinearizabilityHistory
+{
+public:
+	enum class Kind { Store, Remove, Read };
+
+	struct Operation
+	{
+		Kind kind = Kind::Read;
+		K key{};
+		V value{};						//	Store
+		bool succeeded = false;			//	Store - inserted, Remove - removed
+		std::optional<V> read_value{};	//	Read
+		size_t called = 0;
+		size_t returned = std::numeric_limits<size_t>::max();
+	};
+
+	explicit LinearizabilityHistory(std::map<K, V> initial = {}) : initial(std::move(initial)) {}
+
+	template<typename Map>
+	bool store(Map& map, const K& key, const V& value)
+	{
+		const size_t op_idx = call(Operation{ Kind::Store, key, value });
+		const bool inserted = map.store(key, V(value));
+		return_from(op_idx, [&](Operation& op) { op.succeeded = inserted; });
+		return inserted;
+	}
+
+	template<typename Map>
+	bool remove(Map& map, const K& key)
+	{
+		const size_t op_idx = call(Operation{ Kind::Remove, key });
+		const bool removed = map.remove(key);
+		return_from(op_idx, [&](Operation& op) { op.succeeded = removed; });
+		return removed;
+	}
+
+	template<typename Map>
+	std::optional<V> read(Map& map, const K& key)
+	{
+		const size_t op_idx = call(Operation{ Kind::Read, key });
+		const std::optional<V> value = map.read(key);
+		return_from(op_idx, [&](Operation& op) { op.read_value = value; });
+		return value;
+	}
+
+	//	Records the call of an operation, for operations made other than through store/remove/read above
+	size_t call(Operation op)
+	{
+		std::lock_guard lock(mutex);
+		op.called = clock++;
+		operations.push_back(op);
+		return operations.size() - 1;
+	}
+
+	//	Records the return, `complete(Operation&)` fills in the result
+	template<typename F>
+	void return_from(size_t op_idx, F&& complete)
+	{
+		std::lock_guard lock(mutex);
+		complete(operations[op_idx]);
+		operations[op_idx].returned = clock++;
+	}
+
+	//	Throws if no sequential order explains the history. Every operation must have returned.
+	void check() const
+	{
+		std::lock_guard lock(mutex);
+		if (operations.size() > 64)
+			throw std::runtime_error("Linearizability: history is too long, 64 operations at most");
+		for (const Operation& op : operations)
+			if (op.returned == std::numeric_limits<size_t>::max())
+				throw std::runtime_error("Linearizability: operation has not returned");
+
+		std::set<std::pair<uint64_t, std::map<K, V>>> dead_ends;
+		std::map<K, V> state = initial;
+		if (!linearize(0, state, dead_ends))
+			throw std::runtime_error("Linearizability: history of " + std::to_string(operations.size()) + " operations is not linearizable");
+	}
+
+	const std::vector<Operation>& history() const { return operations; }
+
+private:
+	//	Wing & Gong search: next in the order is any pending operation called before every other pending one returned.
+	//	Same set of done operations leading to the same state is a dead end once it failed.
+	bool linearize(uint64_t done, std::map<K, V>& state, std::set<std::pair<uint64_t, std::map<K, V>>>& dead_ends) const
+	{
+		if (done == (operations.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << operations.size()) - 1))
+			return true;
+		if (dead_ends.contains({ done, state }))
+			return false;
+
+		size_t first_return = std::numeric_limits<size_t>::max();
+		for (size_t op_idx = 0; op_idx < operations.size(); ++op_idx)
+			if ((done & (uint64_t(1) << op_idx)) == 0)
+				first_return = std::min(first_return, operations[op_idx].returned);
+
+		for (size_t op_idx = 0; op_idx < operations.size(); ++op_idx)
+		{
+			const Operation& op = operations[op_idx];
+			if ((done & (uint64_t(1) << op_idx)) != 0 || op.called > first_return)
+				continue;
+
+			const auto found = state.find(op.key);
+			const std::optional<V> previous = found != state.end() ? std::optional<V>(found->second) : std::nullopt;
+			bool matches = false;
+			switch (op.kind)
+			{
+			case Kind::Store: matches = op.succeeded == !previous; break;
+			case Kind::Remove: matches = op.succeeded == bool(previous); break;
+			case Kind::Read: matches = op.read_value == previous; break;
+			}
+			if (!matches)
+				continue;
+
+			if (op.kind == Kind::Store)
+				state[op.key] = op.value;
+			else if (op.kind == Kind::Remove)
+				state.erase(op.key);
+
+			const bool linearized = linearize(done | (uint64_t(1) << op_idx), state, dead_ends);
+
+			if (op.kind != Kind::Read)
+			{
+				if (previous)
+					state[op.key] = *previous;
+				else
+					state.erase(op.key);
+			}
+			if (linearized)
+				return true;
+		}
+
+		dead_ends.insert({ done, state });
+		return false;
+	}
+
+	std::map<K, V> initial;
+	mutable std::mutex mutex;
+	std::vector<Operation> operations;
+	size_t clock = 0;
+};
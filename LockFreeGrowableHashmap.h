@@ -0,0 +1,259 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <memory>
+#include <atomic>
+#include <thread>
+
+/*
+* Growable companion of LockFreeFixedSizeHashMap, no capacity to guess upfront:
+*  - Same key/value requirements, single writer, multiple readers, lock free reads
+*  - Starts with `initial_capacity`, doubles once it's 3/4 full instead of throwing
+*  - Supports store (writer), remove (writer), read/read_with (reader/writer), visit all nodes (reader/writer)
+*
+* Built of LockFreeFixedSizeHashMap<K, V, std::dynamic_extent, Traits> tables. Growth allocates a table twice as large
+* and migrates into it incrementally - every following store/remove moves a few nodes over, so no single write pays
+* for copying the whole map. While migrating:
+*  - writes go to the new table, keys moved over are removed from the old one
+*  - readers look into the old table first and then into the new one. Key is copied into the new table before being
+*    removed from the old one, so reader that misses it in the old table finds it in the new one.
+* Once everything is moved, old table is dropped from the readers' sight and freed as soon as readers which still
+* might look at it are done (striped reader counters, RCU style). Only the writer ever waits, readers never block.
+*
+* Usage:
+*	LockFreeGrowableHashMap<int, Quote> quotes(1024);
+*	quotes.store(key, quote);
+*	std::optional<Quote> quote = quotes.read(key);
+*/
+
+namespace details {
+	//	Tells the writer when readers which might have seen the previous state are all gone (sleepable RCU style).
+	//	Readers count themselves in one of two groups, by the phase at the moment they entered. Writer flips the phase
+	//	and waits for the old group to drain - readers entering after the flip go to the other group and can't starve it.
+	//	Counters are striped by thread, so readers don't bounce a single cache line between cores.
+	template<typename Schedule = hashmap_policy::NoSchedulePoints>
+	class ReadersTracker
+	{
+		static constexpr size_t Stripes = 16;
+
+		struct alignas(64) Stripe
+		{
+			std::atomic<int64_t> readers[2] = {};
+		};
+
+	public:
+		class Guard
+		{
+		public:
+			explicit Guard(std::atomic<int64_t>& counter) : counter(counter) {}
+			~Guard() { counter.fetch_sub(1, std::memory_order_release); }
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+		private:
+			std::atomic<int64_t>& counter;
+		};
+
+		Guard enter()
+		{
+			static thread_local size_t stripe_idx = std::hash<std::thread::id>()(std::this_thread::get_id()) % Stripes;
+
+			while (true)
+			{
+				const size_t entered_phase = phase.load(std::memory_order_seq_cst);
+				Schedule::point(hashmap_policy::SchedulePoint::ReaderEnter);
+				std::atomic<int64_t>& counter = stripes[stripe_idx].readers[entered_phase & 1];
+				counter.fetch_add(1, std::memory_order_seq_cst);
+
+				//	Phase still the same - increment is ordered before the next flip, writer waiting for this group sees it.
+				//	Otherwise the group might have been drained already, and staying in it would let the writer free
+				//	tables published after that flip from under the reader. Leave it and join the current one.
+				if (phase.load(std::memory_order_seq_cst) == entered_phase)
+					return Guard(counter);
+				counter.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		//	Writer. Returns once every reader entered before the call is gone.
+		void synchronize()
+		{
+			const size_t old_phase = phase.fetch_add(1, std::memory_order_seq_cst) & 1;
+			int wait_duration = 10;
+			while (readers_num(old_phase) != 0)
+			{
+				for (int i = 0; i < wait_duration; ++i)
+					_mm_pause();
+				if (wait_duration < 1000)
+					wait_duration *= 2;
+				else
+					std::this_thread::yield();
+			}
+		}
+
+	private:
+		int64_t readers_num(size_t phase_idx) const
+		{
+			int64_t readers = 0;
+			for (const Stripe& stripe : stripes)
+				readers += stripe.readers[phase_idx].load(std::memory_order_seq_cst);
+			return readers;
+		}
+
+		alignas(64) std::atomic<size_t> phase = 0;
+		Stripe stripes[Stripes];
+	};
+}
+
+
+template<typename K, typename V, typename Traits = hashmap_policy::DefaultTraits>
+class LockFreeGrowableHashMap
+{
+	using Table = LockFreeFixedSizeHashMap<K, V, std::dynamic_extent, Traits>;
+	static_assert(!Traits::Writers::Concurrent, "Growable hash map supports single writer only");
+	static_assert(!Traits::Eviction::Enabled, "Growable hash map grows instead of evicting");
+
+	//	nodes of the old table moved over by every write while migrating
+	static constexpr size_t MigrationStep = 8;
+
+public:
+	explicit LockFreeGrowableHashMap(size_t initial_capacity = 1024)
+		: current_owner(std::make_unique<Table>(std::max<size_t>(initial_capacity, 16)))
+	{
+		current.store(current_owner.get(), std::memory_order_release);
+	}
+
+	~LockFreeGrowableHashMap() = default;
+	LockFreeGrowableHashMap(const LockFreeGrowableHashMap&) = delete;
+	LockFreeGrowableHashMap& operator=(const LockFreeGrowableHashMap&) = delete;
+
+	//	Returns true if the key was inserted, false if its value was overwritten
+	bool store(const K& key, const V& value)
+	{
+		migrate(MigrationStep);
+		if (elems_num >= current_owner->capacity() / 4 * 3)
+			grow();
+
+		bool inserted = current_owner->store(key, V(value));
+		//	copy in the old table is gone only after the new one is visible
+		if (previous_owner && previous_owner->remove(key))
+			inserted = false;
+
+		if (inserted)
+			++elems_num;
+		return inserted;
+	}
+
+	template<typename CompatibleK>
+	bool remove(const CompatibleK& key)
+	{
+		migrate(MigrationStep);
+
+		bool removed = previous_owner && previous_owner->remove(key);
+		removed = current_owner->remove(key) || removed;
+
+		if (removed)
+			--elems_num;
+		return removed;
+	}
+
+	template<typename CompatibleK>
+	std::optional<V> read(const CompatibleK& key)
+	{
+		return read_with(key, [](const V& value) { return value; });
+	}
+
+	//	Same as LockFreeFixedSizeHashMap::read_with
+	template<typename CompatibleK, typename F>
+	auto read_with(const CompatibleK& key, F&& project)
+	{
+		auto guard = readers.enter();
+
+		while (true)
+		{
+			//	current first: growth publishes the old table as previous before replacing current
+			Table* current_table = current.load(std::memory_order_seq_cst);
+			Table* previous_table = previous.load(std::memory_order_seq_cst);
+
+			auto result = previous_table ? previous_table->read_with(key, project) : std::nullopt;
+			if (!result)
+				result = current_table->read_with(key, project);
+
+			//	Table we've read as current might have been replaced and migrated away meanwhile, then the miss means nothing.
+			//	While it stays current, keys are only ever copied into it before being removed from the previous one.
+			if (result || current.load(std::memory_order_seq_cst) == current_table)
+				return result;
+		}
+	}
+
+	//	Same guarantees as LockFreeFixedSizeHashMap::visit, plus keys being migrated might be visited twice
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit(F func)
+	{
+		auto guard = readers.enter();
+
+		Table* current_table = current.load(std::memory_order_seq_cst);
+		Table* previous_table = previous.load(std::memory_order_seq_cst);
+		if (previous_table)
+			previous_table->visit(func);
+		current_table->visit(func);
+	}
+
+	//	writer only
+	size_t size() const { return elems_num; }
+	size_t capacity() const { return current_owner->capacity(); }
+	bool migrating() const { return previous_owner != nullptr; }
+
+private:
+	void grow()
+	{
+		//	previous growth has to be complete first, normally it is long done by now
+		while (previous_owner)
+			migrate(previous_owner->capacity());
+
+		previous_owner = std::move(current_owner);
+		current_owner = std::make_unique<Table>(previous_owner->capacity() * 2);
+		migration_cursor = 0;
+
+		previous.store(previous_owner.get(), std::memory_order_seq_cst);
+		current.store(current_owner.get(), std::memory_order_seq_cst);
+	}
+
+	//	moves live nodes of the next `nodes_num` node slots of the old table into the current one
+	void migrate(size_t nodes_num)
+	{
+		if (!previous_owner)
+			return;
+
+		Table& old_table = *previous_owner;
+		const size_t migration_end = std::min(old_table.capacity(), migration_cursor + nodes_num);
+		for (; migration_cursor < migration_end; ++migration_cursor)
+		{
+			//	writer is the only one to change nodes, no need to guard the reads
+			auto node = old_table.nodes[migration_cursor];
+			if ((node.part_of_bucket & Table::RetiredBucketTag) != 0)
+				continue;
+
+			const K key = node.key;
+			current_owner->store(key, V(node.value));
+			old_table.remove(key);
+		}
+
+		if (migration_cursor == old_table.capacity())
+		{
+			previous.store(nullptr, std::memory_order_seq_cst);
+			readers.synchronize();
+			previous_owner.reset();
+		}
+	}
+
+	std::atomic<Table*> current = nullptr;
+	std::atomic<Table*> previous = nullptr;	//	table being migrated from, readers look into it first
+	details::ReadersTracker<typename Traits::Schedule> readers;
+
+	//	writer only
+	std::unique_ptr<Table> current_owner;
+	std::unique_ptr<Table> previous_owner;
+	size_t migration_cursor = 0;
+	size_t elems_num = 0;
+};
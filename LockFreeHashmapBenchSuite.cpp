@@ -0,0 +1,429 @@
+#include "LockFreeFixedSizeHashmap.h"
+#include <bit>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+
+//	Benchmark suite of LockFreeFixedSizeHashMap, separate executable for regression tracking (micro benchmarks of
+//	particular features stay in `STL-Helpers --bench`). Runs a matrix of
+//	  map       x  workload (read only, 95/5, 50/50 read/write)  x  hit ratio  x  threads  x  map fill
+//	and prints one record per case - ops/sec and p50/p99/p999/max latency - as CSV (default) or JSON.
+//
+//	Maps:
+//	  lockfree         - default traits (single writer). Thread 0 runs the workload mix, the rest only read -
+//	                     the way the map is meant to be used.
+//	  lockfree_mw      - MultiWriter traits, every thread runs the workload mix
+//	  unordered_map    - baseline, std::unordered_map behind std::shared_mutex, every thread runs the workload mix
+//
+//	Writes overwrite keys already in the map, so the fill stays the same throughout the run.
+//	Numbers make sense only for optimized builds.
+//
+//	Usage: LockFreeHashmapBenchSuite [--format csv|json] [--duration-ms 100] [--threads 1,2,4] [--fills 10,50,90,99]
+//	                                 [--hits 100,50] [--maps lockfree,lockfree_mw,unordered_map] [--sample 8]
+
+namespace {
+	constexpr size_t c_capacity = 1 << 20;
+
+	//	keeps the compiler from throwing away the reads
+	std::atomic<uint64_t> sink = 0;
+
+	//	Latency histogram, HDR style: buckets grow with the value, so relative precision is the same at any magnitude
+	//	(32 sub-buckets per power of 2, ~3%) and the whole 64 bit range fits into 2048 counters.
+	class LatencyHistogram
+	{
+		static constexpr int SubBucketBits = 5;
+		static constexpr uint64_t SubBuckets = 1 << SubBucketBits;
+		static constexpr size_t BucketsNum = 64 * SubBuckets;
+
+	public:
+		void record(uint64_t ns)
+		{
+			++counts[bucket_of(ns)];
+			++total;
+			max_ns = std::max(max_ns, ns);
+		}
+
+		void merge(const LatencyHistogram& other)
+		{
+			for (size_t bucket = 0; bucket < BucketsNum; ++bucket)
+				counts[bucket] += other.counts[bucket];
+			total += other.total;
+			max_ns = std::max(max_ns, other.max_ns);
+		}
+
+		//	highest value of the bucket the quantile falls into
+		uint64_t percentile(double quantile) const
+		{
+			if (total == 0)
+				return 0;
+
+			const uint64_t rank = std::max<uint64_t>(1, uint64_t(quantile * double(total) + 0.5));
+			uint64_t seen = 0;
+			for (size_t bucket = 0; bucket < BucketsNum; ++bucket)
+			{
+				seen += counts[bucket];
+				if (seen >= rank)
+					return std::min(max_ns, highest_of(bucket));
+			}
+			return max_ns;
+		}
+
+		uint64_t max() const { return max_ns; }
+
+	private:
+		//	values below SubBuckets are exact, above - exponent selects the row, next SubBucketBits bits the bucket in it
+		static size_t bucket_of(uint64_t ns)
+		{
+			if (ns < SubBuckets)
+				return size_t(ns);
+			const int shift = std::bit_width(ns) - 1 - SubBucketBits;
+			return size_t(shift + 1) * SubBuckets + size_t((ns >> shift) & (SubBuckets - 1));
+		}
+
+		static uint64_t highest_of(size_t bucket)
+		{
+			if (bucket < SubBuckets)
+				return bucket;
+			const int shift = int(bucket / SubBuckets) - 1;
+			const uint64_t lowest = (SubBuckets + bucket % SubBuckets) << shift;
+			return lowest + (uint64_t(1) << shift) - 1;
+		}
+
+		std::vector<uint64_t> counts = std::vector<uint64_t>(BucketsNum);
+		uint64_t total = 0;
+		uint64_t max_ns = 0;
+	};
+
+	struct Workload
+	{
+		const char* name;
+		uint32_t read_percent;
+	};
+
+	constexpr Workload c_workloads[] = { { "read_only", 100 }, { "read_95_write_5", 95 }, { "read_50_write_50", 50 } };
+
+	struct Options
+	{
+		bool json = false;
+		std::chrono::milliseconds duration{ 100 };
+		std::vector<size_t> threads = { 1, 2, 4, 8, 16, 32, 64 };
+		std::vector<size_t> fill_percents = { 10, 50, 90, 99 };
+		std::vector<size_t> hit_percents = { 100, 50 };
+		std::vector<std::string> maps = { "lockfree", "lockfree_mw", "unordered_map" };
+		uint32_t sample_every = 8;	//	latency of every n-th operation is measured, the clock is not free
+	};
+
+	struct CaseResult
+	{
+		std::string map;
+		const Workload* workload;
+		size_t hit_percent;
+		size_t threads;
+		size_t fill_percent;
+		uint64_t ops;
+		double seconds;
+		LatencyHistogram latency;
+	};
+
+	//	Keys present in the map are key_of(0..fill), missing ones key_of(c_capacity..). Odd multiplier - no collisions.
+	uint64_t key_of(uint64_t idx)
+	{
+		return idx * 0x9E3779B97F4A7C15ULL;
+	}
+
+	//	-----------------------------------
+
+	struct MultiWriterTraits : hashmap_policy::DefaultTraits { using Writers = hashmap_policy::MultiWriter; };
+
+	template<typename Traits, bool SingleWriter>
+	class LockFreeTarget
+	{
+	public:
+		static constexpr bool AllThreadsWrite = !SingleWriter;
+
+		bool read(uint64_t key) { return map->read(key).has_value(); }
+		void write(uint64_t key, uint64_t value) { map->store(key, uint64_t(value)); }
+
+	private:
+		std::unique_ptr<LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_capacity, Traits>> map =
+			std::make_unique<LockFreeFixedSizeHashMap<uint64_t, uint64_t, c_capacity, Traits>>();
+	};
+
+	class UnorderedMapTarget
+	{
+	public:
+		static constexpr bool AllThreadsWrite = true;
+
+		UnorderedMapTarget() { map.reserve(c_capacity); }
+
+		bool read(uint64_t key)
+		{
+			std::shared_lock lock(mutex);
+			return map.find(key) != map.end();
+		}
+
+		void write(uint64_t key, uint64_t value)
+		{
+			std::unique_lock lock(mutex);
+			map[key] = value;
+		}
+
+	private:
+		std::shared_mutex mutex;
+		std::unordered_map<uint64_t, uint64_t> map;
+	};
+
+	//	-----------------------------------
+
+	template<typename Target>
+	CaseResult run_case(Target& target, const Options& options, const Workload& workload, size_t hit_percent, size_t threads_num, size_t keys_num)
+	{
+		std::atomic<size_t> ready = 0;
+		std::atomic<bool> go = false;
+		std::atomic<bool> stop = false;
+		std::vector<uint64_t> ops(threads_num);
+		std::vector<LatencyHistogram> latencies(threads_num);
+
+		std::vector<std::jthread> threads;
+		for (size_t thread_idx = 0; thread_idx < threads_num; ++thread_idx)
+		{
+			threads.emplace_back([&, thread_idx] {
+				std::mt19937_64 gen(thread_idx + 1);
+				const uint32_t read_percent = (Target::AllThreadsWrite || thread_idx == 0) ? workload.read_percent : 100;
+				LatencyHistogram& latency = latencies[thread_idx];
+				uint64_t done = 0;
+				uint64_t hits = 0;
+
+				ready.fetch_add(1);
+				while (!go.load(std::memory_order_acquire))
+					std::this_thread::yield();
+
+				while (!stop.load(std::memory_order_relaxed))
+				{
+					//	stop flag is checked once per round, not to disturb the loop
+					for (int i = 0; i < 64; ++i, ++done)
+					{
+						const uint64_t rnd = gen();
+						const bool is_read = rnd % 100 < read_percent;
+						const bool is_hit = !is_read || (rnd >> 8) % 100 < hit_percent;
+						const uint64_t key = is_hit ? key_of((rnd >> 16) % keys_num) : key_of(c_capacity + (rnd >> 16) % c_capacity);
+
+						const bool timed = done % options.sample_every == 0;
+						const auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+						if (is_read)
+							hits += target.read(key);
+						else
+							target.write(key, rnd);
+						if (timed)
+							latency.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+					}
+				}
+
+				ops[thread_idx] = done;
+				sink.fetch_add(hits, std::memory_order_relaxed);
+			});
+		}
+
+		while (ready.load() != threads_num)
+			std::this_thread::yield();
+
+		const auto start = std::chrono::steady_clock::now();
+		go.store(true, std::memory_order_release);
+		std::this_thread::sleep_for(options.duration);
+		stop.store(true, std::memory_order_relaxed);
+		threads.clear();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		CaseResult result{ {}, &workload, hit_percent, threads_num, 0, 0, elapsed.count(), {} };
+		for (size_t thread_idx = 0; thread_idx < threads_num; ++thread_idx)
+		{
+			result.ops += ops[thread_idx];
+			result.latency.merge(latencies[thread_idx]);
+		}
+		return result;
+	}
+
+	void print_header(const Options& options)
+	{
+		if (options.json)
+			std::cout << "[\n";
+		else
+			std::cout << "map,workload,read_percent,hit_percent,threads,fill_percent,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns\n";
+	}
+
+	void print_result(const Options& options, const CaseResult& result, bool first)
+	{
+		struct Field
+		{
+			const char* name;
+			std::string value;
+			bool text;
+		};
+
+		const Field fields[] = {
+			{ "map", result.map, true },
+			{ "workload", result.workload->name, true },
+			{ "read_percent", std::to_string(result.workload->read_percent), false },
+			{ "hit_percent", std::to_string(result.hit_percent), false },
+			{ "threads", std::to_string(result.threads), false },
+			{ "fill_percent", std::to_string(result.fill_percent), false },
+			{ "ops", std::to_string(result.ops), false },
+			{ "ops_per_sec", std::to_string(uint64_t(double(result.ops) / result.seconds)), false },
+			{ "p50_ns", std::to_string(result.latency.percentile(0.5)), false },
+			{ "p99_ns", std::to_string(result.latency.percentile(0.99)), false },
+			{ "p999_ns", std::to_string(result.latency.percentile(0.999)), false },
+			{ "max_ns", std::to_string(result.latency.max()), false },
+		};
+
+		std::string line;
+		for (const Field& field : fields)
+		{
+			if (options.json)
+				line += (line.empty() ? "  {" : ", ") + ("\"" + std::string(field.name) + "\": ") + (field.text ? "\"" + field.value + "\"" : field.value);
+			else
+				line += (line.empty() ? "" : ",") + field.value;
+		}
+
+		if (options.json)
+			std::cout << (first ? "" : ",\n") << line << "}";
+		else
+			std::cout << line << "\n";
+		std::cout.flush();
+	}
+
+	void print_footer(const Options& options)
+	{
+		if (options.json)
+			std::cout << "\n]\n";
+	}
+
+	//	Map is filled once per fill ratio and then goes through the whole workloads x hits x threads matrix
+	template<typename Target>
+	void run_map(const std::string& name, const Options& options, bool& first)
+	{
+		for (size_t fill_percent : options.fill_percents)
+		{
+			const size_t keys_num = std::max<size_t>(1, c_capacity * fill_percent / 100);
+			auto target = std::make_unique<Target>();
+			for (size_t idx = 0; idx < keys_num; ++idx)
+				target->write(key_of(idx), idx);
+
+			for (const Workload& workload : c_workloads)
+				for (size_t hit_percent : options.hit_percents)
+					for (size_t threads_num : options.threads)
+					{
+						CaseResult result = run_case(*target, options, workload, hit_percent, threads_num, keys_num);
+						result.map = name;
+						result.fill_percent = fill_percent;
+						print_result(options, result, first);
+						first = false;
+					}
+		}
+	}
+
+	//	-----------------------------------
+
+	template<typename T>
+	std::vector<T> parse_list(std::string_view list)
+	{
+		std::vector<T> values;
+		while (!list.empty())
+		{
+			const size_t comma = std::min(list.find(','), list.size());
+			const std::string item(list.substr(0, comma));
+			if constexpr (std::is_same_v<T, std::string>)
+				values.push_back(item);
+			else
+				values.push_back(T(std::stoull(item)));
+			list.remove_prefix(std::min(comma + 1, list.size()));
+		}
+		return values;
+	}
+
+	Options parse_options(int argc, char* argv[])
+	{
+		Options options;
+		for (int arg_idx = 1; arg_idx < argc; ++arg_idx)
+		{
+			const std::string_view arg = argv[arg_idx];
+			if (arg_idx + 1 == argc)
+				throw std::runtime_error("Missing value of " + std::string(arg));
+			const std::string_view value = argv[++arg_idx];
+
+			if (arg == "--format")
+			{
+				if (value != "csv" && value != "json")
+					throw std::runtime_error("Unknown format " + std::string(value));
+				options.json = value == "json";
+			}
+			else if (arg == "--duration-ms")
+				options.duration = std::chrono::milliseconds(std::stoull(std::string(value)));
+			else if (arg == "--threads")
+				options.threads = parse_list<size_t>(value);
+			else if (arg == "--fills")
+				options.fill_percents = parse_list<size_t>(value);
+			else if (arg == "--hits")
+				options.hit_percents = parse_list<size_t>(value);
+			else if (arg == "--maps")
+				options.maps = parse_list<std::string>(value);
+			else if (arg == "--sample")
+				options.sample_every = std::max<uint32_t>(1, uint32_t(std::stoul(std::string(value))));
+			else
+				throw std::runtime_error("Unknown option " + std::string(arg));
+		}
+
+		for (size_t threads_num : options.threads)
+			if (threads_num == 0)
+				throw std::runtime_error("Threads count must be positive");
+		for (size_t fill_percent : options.fill_percents)
+			if (fill_percent == 0 || fill_percent > 100)
+				throw std::runtime_error("Fill is a percent of the map capacity, 1 to 100");
+		for (size_t hit_percent : options.hit_percents)
+			if (hit_percent > 100)
+				throw std::runtime_error("Hit ratio is a percent, 0 to 100");
+		return options;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const Options options = parse_options(argc, argv);
+
+		bool first = true;
+		print_header(options);
+		for (const std::string& map : options.maps)
+		{
+			if (map == "lockfree")
+				run_map<LockFreeTarget<hashmap_policy::DefaultTraits, true>>(map, options, first);
+			else if (map == "lockfree_mw")
+				run_map<LockFreeTarget<MultiWriterTraits, false>>(map, options, first);
+			else if (map == "unordered_map")
+				run_map<UnorderedMapTarget>(map, options, first);
+			else
+				throw std::runtime_error("Unknown map " + map);
+		}
+		print_footer(options);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <immintrin.h>
+#include "LockFreeFixedSizeHashmap.h"
+
+/*
+* Open addressing counterpart of LockFreeFixedSizeHashMap (swiss table style). Same properties and guarantees:
+*  - Requires trivial Key/Value types, fixed size, throws on overfill
+*  - Single writer, multiple readers, lock free
+*  - Supports store (writer), remove (writer), read (reader/writer), visit all nodes (reader/writer)
+*  - Keys are hashed and compared by Traits::Hash/KeyEqual, other traits are not supported and must stay default
+*
+* Slots are split into groups of 16 (32 with AVX2), every group keeps a control byte per slot holding 7 bits of the key hash,
+* those are matched all at once with SIMD. Lookup of a present key usually touches the group header and a single slot,
+* instead of following the chain of nodes.
+*
+* Every group is guarded by its own version (seqlock, same odd/even protocol as nodes of LockFreeFixedSizeHashMap).
+* Probing stops at the first group that no key has ever overflowed from (F14 style overflow counter), so removal
+* leaves no tombstones and misses stay short even under heavy churn.
+*/
+
+namespace details {
+	//	Snapshot of control bytes of one group, matched with SIMD
+	class ControlGroup
+	{
+	public:
+		static constexpr uint8_t Empty = 0x80;	//	any full slot has highest bit cleared
+
+#if defined(__AVX2__)
+		static constexpr size_t Width = 32;
+		using Mask = uint32_t;
+
+		explicit ControlGroup(const uint8_t* ctrl) : ctrl(_mm256_load_si256(reinterpret_cast<const __m256i*>(ctrl))) {}
+
+		Mask match(uint8_t tag) const { return Mask(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(char(tag))))); }
+		Mask match_empty() const { return Mask(_mm256_movemask_epi8(ctrl)); }
+		Mask match_full() const { return ~match_empty(); }
+
+	private:
+		__m256i ctrl;
+#else
+		static constexpr size_t Width = 16;
+		using Mask = uint16_t;
+
+		explicit ControlGroup(const uint8_t* ctrl) : ctrl(_mm_load_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+		Mask match(uint8_t tag) const { return Mask(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(tag))))); }
+		Mask match_empty() const { return Mask(_mm_movemask_epi8(ctrl)); }
+		Mask match_full() const { return Mask(~match_empty()); }
+
+	private:
+		__m128i ctrl;
+#endif
+	};
+
+	//	std::hash is identity for integers on most of the implementations, which puts sequential keys into the same group.
+	//	Fold of 128 bit multiplication spreads all bits of the input over the result.
+	inline uint64_t mix_hash(uint64_t h)
+	{
+		return mum(h, 0x9E3779B97F4A7C15ULL);
+	}
+}
+
+
+template<typename K, typename V, size_t MaxElems, typename Traits = hashmap_policy::DefaultTraits>
+	requires std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>
+class LockFreeOpenAddressingHashMap
+{
+	using Hash = typename Traits::template Hash<K>;
+	using KeyEqual = typename Traits::KeyEqual;
+	using Defaults = hashmap_policy::DefaultTraits;
+	static_assert(std::is_same_v<typename Traits::NodeLayout, Defaults::NodeLayout>, "Open addressing map has its own layout");
+	static_assert(!Traits::Writers::Concurrent, "Open addressing map supports single writer only");
+	static_assert(std::is_same_v<typename Traits::Buckets, Defaults::Buckets>, "Open addressing map has groups instead of buckets");
+	static_assert(std::is_same_v<typename Traits::Backoff, Defaults::Backoff>, "Open addressing map does not support backoff policies");
+	static_assert(std::is_same_v<typename Traits::Stats, Defaults::Stats>, "Open addressing map does not support stats");
+	static_assert(!Traits::Reclamation::Deferred, "Open addressing map does not support deferred reclamation");
+	static_assert(Traits::Index::Levels == 0, "Open addressing map does not support the sorted index");
+	static_assert(!Traits::Eviction::Enabled, "Open addressing map does not support eviction");
+	static_assert(std::is_same_v<typename Traits::Schedule, Defaults::Schedule>, "Open addressing map has no schedule points");
+
+	using ControlGroup = details::ControlGroup;
+	static constexpr size_t GroupWidth = ControlGroup::Width;
+	//	max load factor is 7/8, groups count is a power of 2 so triangular probing visits each group once
+	static constexpr size_t GroupsNum = std::bit_ceil((MaxElems * 8 / 7 + GroupWidth) / GroupWidth);
+	static constexpr size_t SlotsNum = GroupsNum * GroupWidth;
+	static constexpr size_t NoGroup = std::numeric_limits<size_t>::max();
+
+public:
+	LockFreeOpenAddressingHashMap()
+	{
+		for (Group& group : groups)
+			std::fill(std::begin(group.ctrl), std::end(group.ctrl), ControlGroup::Empty);
+	}
+
+	void store(const K& key, auto&& value) requires(std::is_same_v<std::decay_t<decltype(value)>, V>)
+	{
+		const size_t hash = hash_of(key);
+		const uint8_t tag = tag_of(hash);
+
+		//	look for the existing key, stopping at the first group nothing overflowed from
+		size_t probe = 0;
+		size_t free_probe = NoGroup;
+		for (; probe < GroupsNum; ++probe)
+		{
+			const size_t group_idx = group_of(hash, probe);
+			Group& group = groups[group_idx];
+			ControlGroup ctrl(group.ctrl);
+			for (auto matches = ctrl.match(tag); matches != 0; matches &= matches - 1)
+			{
+				Slot& slot = slots[group_idx * GroupWidth + std::countr_zero(matches)];
+				if (keys_equal(slot.key, key))
+				{
+					//	version is odd (readers stay away)
+					group.version.fetch_add(1, std::memory_order_acq_rel);
+					slot.value = std::forward<V>(value);
+					//	mark version as even (readers good to go (but may need to reread))
+					group.version.fetch_add(1, std::memory_order_acq_rel);
+					return;
+				}
+			}
+
+			if (free_probe == NoGroup && ctrl.match_empty() != 0)
+				free_probe = probe;
+
+			if (group.overflow.load(std::memory_order_relaxed) == 0)
+				break;
+		}
+
+		if (size == MaxElems)
+			throw std::runtime_error("Hash map overflow");
+
+		//	not found, key goes into the first group with free slot on its probing path
+		for (probe = (free_probe == NoGroup ? probe + 1 : free_probe); free_probe == NoGroup; ++probe)
+		{
+			assert(probe < GroupsNum);	//	load factor guarantees free slots
+			if (ControlGroup(groups[group_of(hash, probe)].ctrl).match_empty() != 0)
+				free_probe = probe;
+		}
+
+		//	Groups we skipped are marked first, so the moment new key becomes visible readers are already allowed to probe that far.
+		for (probe = 0; probe < free_probe; ++probe)
+		{
+			auto& overflow = groups[group_of(hash, probe)].overflow;
+			overflow.store(overflow.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		const size_t group_idx = group_of(hash, free_probe);
+		Group& group = groups[group_idx];
+		const size_t slot_in_group = std::countr_zero(ControlGroup(group.ctrl).match_empty());
+		Slot& slot = slots[group_idx * GroupWidth + slot_in_group];
+
+		group.version.fetch_add(1, std::memory_order_acq_rel);
+		slot.key = key;
+		slot.value = std::forward<V>(value);
+		group.ctrl[slot_in_group] = tag;
+		group.version.fetch_add(1, std::memory_order_acq_rel);
+
+		++size;
+	}
+
+	template<typename CompatibleK>
+	std::optional<V> read(const CompatibleK& key)
+	{
+		const size_t hash = hash_of(key);
+		const uint8_t tag = tag_of(hash);
+		auto do_pause = pause_closure();
+
+		for (size_t probe = 0; probe < GroupsNum; ++probe)
+		{
+			const Group& group = groups[group_of(hash, probe)];
+			const Slot* group_slots = &slots[group_of(hash, probe) * GroupWidth];
+
+			while (true)
+			{
+				size_t before_version = group.version.load(std::memory_order_acquire);
+				if (before_version % 2 == 1)
+				{
+					//	group is being altered, retrying
+					do_pause();
+					continue;
+				}
+
+				//	All reads below are speculative, those are valid only if group version didn't change.
+				ControlGroup ctrl(group.ctrl);
+				std::optional<V> result;
+				for (auto matches = ctrl.match(tag); matches != 0; matches &= matches - 1)
+				{
+					const Slot& slot = group_slots[std::countr_zero(matches)];
+					if (keys_equal(slot.key, key))
+					{
+						result = slot.value;
+						break;
+					}
+				}
+				const bool overflowed = group.overflow.load(std::memory_order_acquire) != 0;
+
+				size_t after_version = group.version.load(std::memory_order_acquire);
+				if (before_version != after_version)
+				{
+					do_pause();
+					continue;
+				}
+
+				if (result || !overflowed)
+					return result;
+
+				//	key might have overflowed into the next group
+				break;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	template<typename CompatibleK>
+	bool remove(const CompatibleK& key)
+	{
+		const size_t hash = hash_of(key);
+		const uint8_t tag = tag_of(hash);
+
+		for (size_t probe = 0; probe < GroupsNum; ++probe)
+		{
+			const size_t group_idx = group_of(hash, probe);
+			Group& group = groups[group_idx];
+			ControlGroup ctrl(group.ctrl);
+			for (auto matches = ctrl.match(tag); matches != 0; matches &= matches - 1)
+			{
+				const size_t slot_in_group = std::countr_zero(matches);
+				if (!keys_equal(slots[group_idx * GroupWidth + slot_in_group].key, key))
+					continue;
+
+				group.version.fetch_add(1, std::memory_order_acq_rel);
+				group.ctrl[slot_in_group] = ControlGroup::Empty;
+				group.version.fetch_add(1, std::memory_order_acq_rel);
+
+				//	Key is gone, only now groups on its way may stop advertising overflow.
+				//	Freed slot is plain empty (no tombstone) - probing does not rely on empty slots to stop.
+				for (size_t passed = 0; passed < probe; ++passed)
+				{
+					auto& overflow = groups[group_of(hash, passed)].overflow;
+					assert(overflow.load(std::memory_order_relaxed) > 0);
+					overflow.store(overflow.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+				}
+
+				--size;
+				return true;
+			}
+
+			if (group.overflow.load(std::memory_order_relaxed) == 0)
+				break;
+		}
+
+		return false;
+	}
+
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit(F func)
+	{
+		//	Same guarantees as LockFreeFixedSizeHashMap::visit - newly inserted keys might be missed,
+		//	key removed and reinserted into another group might be visited twice.
+		for (size_t group_idx = 0; group_idx < GroupsNum; ++group_idx)
+		{
+			const Group& group = groups[group_idx];
+			auto do_pause = pause_closure();
+
+			std::pair<K, V> pairs[GroupWidth];
+			size_t pairs_num = 0;
+			while (true)
+			{
+				size_t before_version = group.version.load(std::memory_order_acquire);
+				if (before_version % 2 == 1)
+				{
+					do_pause();
+					continue;
+				}
+
+				pairs_num = 0;
+				for (auto full = ControlGroup(group.ctrl).match_full(); full != 0; full &= full - 1)
+				{
+					const Slot& slot = slots[group_idx * GroupWidth + std::countr_zero(full)];
+					pairs[pairs_num++] = std::make_pair(slot.key, slot.value);
+				}
+
+				size_t after_version = group.version.load(std::memory_order_acquire);
+				if (before_version == after_version)
+					break;
+			}
+
+			for (size_t i = 0; i < pairs_num; ++i)
+				func(pairs[i]);
+		}
+	}
+
+private:
+	struct alignas(64) Group
+	{
+		//	constantly increasing version of the whole group
+		//	odd - being changed
+		//  even - ready to read
+		std::atomic<size_t> version = 0;
+		//	number of keys which probed past this group because it was full, lookup continues to the next group only if non zero
+		std::atomic<uint32_t> overflow = 0;
+		alignas(GroupWidth) uint8_t ctrl[GroupWidth];	//	ControlGroup::Empty or 7 bit tag of the key hash
+	};
+
+	struct Slot
+	{
+		K key;
+		V value;
+	};
+
+	//	Lookup key is hashed as K unless the hasher is transparent, same as LockFreeFixedSizeHashMap::hash_of
+	template<typename CompatibleK>
+	static size_t hash_of(const CompatibleK& key)
+	{
+		if constexpr (std::is_same_v<CompatibleK, K> || requires { typename Hash::is_transparent; })
+			return details::mix_hash(Hash()(key));
+		else
+			return details::mix_hash(Hash()(static_cast<K>(key)));
+	}
+
+	template<typename CompatibleK>
+	static bool keys_equal(const K& slot_key, const CompatibleK& key)
+	{
+		return KeyEqual()(slot_key, key);
+	}
+
+	//	low 7 bits are matched inside of the group, the rest selects the group
+	static uint8_t tag_of(size_t hash) { return uint8_t(hash & 0x7F); }
+
+	static size_t group_of(size_t hash, size_t probe)
+	{
+		//	triangular numbers, visit all groups when their number is a power of 2
+		return ((hash >> 7) + probe * (probe + 1) / 2) & (GroupsNum - 1);
+	}
+
+	auto pause_closure() {
+		return [wait_duration = 10]() mutable {
+			//	pause a bit
+			for (int i = 0; i < wait_duration; ++i)
+				_mm_pause();
+
+			wait_duration += 10;
+			};
+	}
+
+	alignas(64) std::array<Group, GroupsNum> groups;
+	alignas(64) std::array<Slot, SlotsNum> slots;
+	size_t size = 0;	//	writer only
+};
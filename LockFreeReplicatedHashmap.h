@@ -0,0 +1,281 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <new>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <exception>
+#include <utility>
+#include <optional>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+/*
+* Read mostly replication of a hash map over NUMA nodes (Map is e.g. LockFreeFixedSizeHashMap<int, Quote, 1000>):
+*  - One copy of the map per NUMA node, its memory is first touched (so allocated) by a thread running on that node
+*  - Single writer fans store/remove out to every replica, readers go to the replica of the node they run on.
+*    Nodes reads and version bumps stay within the socket, nothing crosses the interconnect but the writer's stores.
+*  - Replicas are updated one after another, readers on different nodes may disagree for the duration of a write
+*  - Single NUMA node (or no NUMA support, non Linux) - a single replica, same as the plain map
+*
+* Usage:
+*	NumaReplicatedHashMap<LockFreeFixedSizeHashMap<int, Quote, 1000>> quotes;
+*	quotes.store(key, quote);
+*	std::optional<Quote> quote = quotes.read(key);
+*/
+
+namespace details {
+	//	NUMA nodes and their CPUs as the kernel reports them (sysfs), without libnuma
+	class NumaTopology
+	{
+	public:
+		NumaTopology()
+		{
+#if defined(__linux__)
+			for (size_t node : parse_cpu_list(read_line("/sys/devices/system/node/online")))
+			{
+				std::vector<size_t> cpus = parse_cpu_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+				if (cpus.empty())
+					continue;	//	memory only node
+
+				for (size_t cpu : cpus)
+				{
+					if (cpu >= node_of_cpu.size())
+						node_of_cpu.resize(cpu + 1, 0);
+					node_of_cpu[cpu] = node_cpus.size();
+				}
+				node_cpus.push_back(std::move(cpus));
+			}
+#endif
+			if (node_cpus.empty())
+				node_cpus.emplace_back();	//	single node, any CPU
+		}
+
+		size_t nodes_num() const { return node_cpus.size(); }
+
+		//	Node the calling thread runs on right now (index among nodes with CPUs)
+		size_t current_node() const
+		{
+#if defined(__linux__)
+			const int cpu = sched_getcpu();
+			if (cpu >= 0 && size_t(cpu) < node_of_cpu.size())
+				return node_of_cpu[cpu];
+#endif
+			return 0;
+		}
+
+		//	Keeps the calling thread on CPUs of the node, false if not supported
+		bool pin_current_thread(size_t node) const
+		{
+#if defined(__linux__)
+			if (node_cpus[node].empty())
+				return false;
+
+			cpu_set_t cpu_set;
+			CPU_ZERO(&cpu_set);
+			for (size_t cpu : node_cpus[node])
+				CPU_SET(cpu, &cpu_set);
+			return sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#else
+			(void)node;
+			return false;
+#endif
+		}
+
+	private:
+		static std::string read_line(const std::string& path)
+		{
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		}
+
+		//	"0-3,8,10-11"
+		static std::vector<size_t> parse_cpu_list(const std::string& list)
+		{
+			std::vector<size_t> cpus;
+			size_t pos = 0;
+			while (pos < list.size())
+			{
+				size_t end = list.find(',', pos);
+				if (end == std::string::npos)
+					end = list.size();
+
+				const std::string range = list.substr(pos, end - pos);
+				const size_t dash = range.find('-');
+				try
+				{
+					const size_t first = std::stoul(range.substr(0, dash));
+					const size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+					for (size_t cpu = first; cpu <= last; ++cpu)
+						cpus.push_back(cpu);
+				}
+				catch (const std::logic_error&)
+				{
+					//	malformed entry, skipped
+				}
+				pos = end + 1;
+			}
+			return cpus;
+		}
+
+		std::vector<std::vector<size_t>> node_cpus;
+		std::vector<size_t> node_of_cpu;
+	};
+}
+
+
+template<typename Map>
+class NumaReplicatedHashMap
+{
+public:
+	using key_type = typename Map::key_type;
+	using mapped_type = typename Map::mapped_type;
+
+	//	replica per NUMA node
+	NumaReplicatedHashMap() : NumaReplicatedHashMap(details::NumaTopology().nodes_num()) {}
+
+	//	`replicas_num` replicas, i-th one placed on node i % nodes
+	explicit NumaReplicatedHashMap(size_t replicas_num)
+	{
+		if (replicas_num == 0)
+			throw std::runtime_error("Replicated hash map: at least one replica is required");
+
+		for (size_t replica_idx = 0; replica_idx < replicas_num; ++replica_idx)
+		{
+			const size_t node = replica_idx % topology.nodes_num();
+			if (replica_of_node.size() <= node)
+				replica_of_node.push_back(replica_idx);
+
+			//	constructed on the node - construction writes the whole map, so its pages are allocated there.
+			//	Exception escaping the thread would terminate, it's carried over and rethrown here instead.
+			std::exception_ptr failure;
+			std::jthread([&] {
+				try
+				{
+					topology.pin_current_thread(node);
+					replicas.push_back(make_replica());
+				}
+				catch (...)
+				{
+					failure = std::current_exception();
+				}
+			}).join();
+			if (failure)
+				std::rethrow_exception(failure);
+		}
+	}
+
+	NumaReplicatedHashMap(const NumaReplicatedHashMap&) = delete;
+	NumaReplicatedHashMap& operator=(const NumaReplicatedHashMap&) = delete;
+
+	//	Writer. Returns what the first replica returned (all of them agree).
+	bool store(const key_type& key, const mapped_type& value)
+	{
+		bool inserted = false;
+		for (size_t replica_idx = 0; replica_idx < replicas.size(); ++replica_idx)
+		{
+			const bool replica_inserted = replicas[replica_idx]->store(key, mapped_type(value));
+			if (replica_idx == 0)
+				inserted = replica_inserted;
+		}
+		return inserted;
+	}
+
+	template<typename CompatibleK>
+	bool remove(const CompatibleK& key)
+	{
+		bool removed = false;
+		for (size_t replica_idx = 0; replica_idx < replicas.size(); ++replica_idx)
+		{
+			const bool replica_removed = replicas[replica_idx]->remove(key);
+			if (replica_idx == 0)
+				removed = replica_removed;
+		}
+		return removed;
+	}
+
+	template<typename CompatibleK>
+	std::optional<mapped_type> read(const CompatibleK& key)
+	{
+		return local_replica().read(key);
+	}
+
+	template<typename CompatibleK, typename F>
+	auto read_with(const CompatibleK& key, F&& project)
+	{
+		return local_replica().read_with(key, std::forward<F>(project));
+	}
+
+	template<typename F>	//	func(const std::pair<key, value>&)
+	void visit(F func)
+	{
+		local_replica().visit(func);
+	}
+
+	size_t replicas_num() const { return replicas.size(); }
+
+	//	Replica readers of the calling thread go to
+	size_t local_replica_idx() const
+	{
+		const size_t node = topology.current_node();
+		return node < replica_of_node.size() ? replica_of_node[node] : node % replicas.size();
+	}
+
+	Map& local_replica() { return *replicas[local_replica_idx()]; }
+	Map& replica(size_t replica_idx) { return *replicas[replica_idx]; }
+
+private:
+	struct ReplicaDeleter
+	{
+		void operator()(Map* map) const
+		{
+			map->~Map();
+#if defined(__linux__)
+			munmap(map, sizeof(Map));
+#else
+			::operator delete(map, std::align_val_t(alignof(Map)));
+#endif
+		}
+	};
+
+	using Replica = std::unique_ptr<Map, ReplicaDeleter>;
+
+	static Replica make_replica()
+	{
+#if defined(__linux__)
+		//	fresh pages straight from the kernel, not yet touched by anybody (heap might hand out memory touched on another node)
+		void* memory = mmap(nullptr, sizeof(Map), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+			throw std::bad_alloc();
+#else
+		void* memory = ::operator new(sizeof(Map), std::align_val_t(alignof(Map)));
+#endif
+		try
+		{
+			return Replica(new (memory) Map);
+		}
+		catch (...)
+		{
+#if defined(__linux__)
+			munmap(memory, sizeof(Map));
+#else
+			::operator delete(memory, std::align_val_t(alignof(Map)));
+#endif
+			throw;
+		}
+	}
+
+	details::NumaTopology topology;
+	std::vector<Replica> replicas;
+	std::vector<size_t> replica_of_node;	//	first replica placed on the node
+};
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "LockFreeFixedSizeHashmap.h"
+#include <span>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <string>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+/*
+* Hash map of variable length keys and values (byte strings), built on LockFreeFixedSizeHashMap:
+*  - Keys and values live in a slab arena of ArenaBytes inside of the map object, nodes hold their offsets only.
+*    No pointers anywhere, so the map goes into shared memory as is (create_in/attach_to, SharedMemoryHashMap)
+*  - Slab is a length prefix followed by the bytes, readers copy just as many bytes as there are
+*  - Bytes are guarded by the seqlock of the node referring to them: writer stores new bytes into a new slab,
+*    switches the node over and frees the old slab only then - reader which viewed it finds the node version changed
+*  - Slab sizes are powers of 2, 16 bytes up to 64 KiB. Freed slabs are reused for the same size only,
+*    so the arena might run out of slabs of one size while holding free ones of another (throws then)
+*  - Single writer, compile time capacity. Traits are as for LockFreeFixedSizeHashMap, except of Hash/KeyEqual
+*    (wyhash of the key bytes), Eviction and Index, which are not supported
+*
+* Usage:
+*	LockFreeVarLenHashMap<1000, 1 << 20> symbols;
+*	symbols.store("EURUSD", "Euro / US Dollar");
+*	std::optional<std::string> name = symbols.read("EURUSD");
+*	char buffer[64];
+*	std::optional<size_t> length = symbols.read("EURUSD", buffer);	//	no allocation, length might exceed the buffer
+*/
+
+namespace details {
+	//	Slab allocator over a byte array. Writer stores and frees, readers view speculatively: view() never reaches out
+	//	of the arena, whatever offset (maybe torn) it is given.
+	template<size_t Bytes>
+	class SlabArena
+	{
+		static_assert(Bytes <= std::numeric_limits<uint32_t>::max(), "Slabs are addressed by 32 bit offsets");
+		using Length = uint32_t;
+		static constexpr uint32_t NoSlab = std::numeric_limits<uint32_t>::max();
+
+	public:
+		static constexpr size_t MinSlabSize = 16;
+		static constexpr size_t MaxSlabSize = 64 * 1024;
+		static constexpr size_t MaxLength = MaxSlabSize - sizeof(Length);
+
+		SlabArena()
+		{
+			free_heads.fill(NoSlab);
+		}
+
+		static constexpr size_t capacity() { return Bytes; }
+
+		//	bytes taken by slabs in use, prefixes and rounding up included
+		size_t used() const { return used_bytes.load(std::memory_order_relaxed); }
+
+		//	Writer. Copies `data` into a new slab and returns its offset, throws if there is no room for it.
+		uint32_t store(std::string_view data)
+		{
+			if (data.size() > MaxLength)
+				throw std::runtime_error("Hash map arena: bytes are longer than the largest slab");
+
+			const size_t size_class = class_of(data.size());
+			uint32_t offset = free_heads[size_class];
+			if (offset != NoSlab)
+			{
+				//	freed slab links to the next one of its size
+				std::memcpy(&free_heads[size_class], &bytes[offset + sizeof(Length)], sizeof(uint32_t));
+			}
+			else
+			{
+				if (Bytes - top < slab_size(size_class))
+					throw std::runtime_error("Hash map arena overflow");
+				offset = uint32_t(top);
+				top += slab_size(size_class);
+			}
+
+			const Length length = Length(data.size());
+			std::memcpy(&bytes[offset], &length, sizeof(length));
+			std::memcpy(&bytes[offset + sizeof(Length)], data.data(), data.size());
+			used_bytes.store(used() + slab_size(size_class), std::memory_order_relaxed);
+			return offset;
+		}
+
+		//	Writer. Slab goes back to the list of its size, its length prefix stays.
+		void free(uint32_t offset)
+		{
+			Length length;
+			std::memcpy(&length, &bytes[offset], sizeof(length));
+			const size_t size_class = class_of(length);
+			std::memcpy(&bytes[offset + sizeof(Length)], &free_heads[size_class], sizeof(uint32_t));
+			free_heads[size_class] = offset;
+			used_bytes.store(used() - slab_size(size_class), std::memory_order_relaxed);
+		}
+
+		//	Reader. Bytes of the slab at `offset` - valid only once the node the offset was taken from is validated.
+		std::string_view view(uint32_t offset) const
+		{
+			if (Bytes < sizeof(Length) || offset > Bytes - sizeof(Length))
+				return {};
+
+			Length length;
+			std::memcpy(&length, &bytes[offset], sizeof(length));
+			if (length > MaxLength || length > Bytes - sizeof(Length) - offset)
+				return {};
+
+			return { reinterpret_cast<const char*>(&bytes[offset + sizeof(Length)]), length };
+		}
+
+	private:
+		//	smallest power of 2 multiple of MinSlabSize fitting the prefix and `length` bytes
+		static size_t class_of(size_t length) { return std::bit_width((length + sizeof(Length) - 1) / MinSlabSize); }
+		static size_t slab_size(size_t size_class) { return MinSlabSize << size_class; }
+
+		static constexpr size_t SizeClasses = std::bit_width((MaxSlabSize - 1) / MinSlabSize) + 1;
+
+		//	writer only
+		std::array<uint32_t, SizeClasses> free_heads;
+		size_t top = 0;
+		std::atomic<size_t> used_bytes = 0;
+		//	left uninitialized, every slab is written before its offset is handed out
+		alignas(16) std::array<std::byte, Bytes> bytes;
+	};
+
+	//	Node key: hash of the key bytes and their slab. Keys are unique, so two SlabKeys are equal if they share the slab.
+	struct SlabKey
+	{
+		uint64_t hash;
+		uint32_t offset;
+	};
+
+	//	Node value: slabs of the key (again, for the writer to find the SlabKey of a key) and of the value
+	struct SlabEntry
+	{
+		uint32_t key;
+		uint32_t value;
+	};
+
+	//	Lookup by the key bytes, compared against the slab of the node key
+	template<typename Arena>
+	struct SlabLookup
+	{
+		uint64_t hash;
+		std::string_view bytes;
+		const Arena* arena;
+	};
+
+	struct SlabKeyHash
+	{
+		using is_transparent = void;
+
+		size_t operator()(const SlabKey& key) const { return size_t(key.hash); }
+
+		template<typename Arena>
+		size_t operator()(const SlabLookup<Arena>& lookup) const { return size_t(lookup.hash); }
+	};
+
+	struct SlabKeyEqual
+	{
+		bool operator()(const SlabKey& node_key, const SlabKey& key) const { return node_key.offset == key.offset && node_key.hash == key.hash; }
+
+		template<typename Arena>
+		bool operator()(const SlabKey& node_key, const SlabLookup<Arena>& lookup) const
+		{
+			return node_key.hash == lookup.hash && lookup.arena->view(node_key.offset) == lookup.bytes;
+		}
+	};
+
+	template<typename Traits>
+	struct SlabTraits : Traits
+	{
+		template<typename K>
+		using Hash = SlabKeyHash;
+		using KeyEqual = SlabKeyEqual;
+	};
+}
+
+
+template<size_t MaxElems, size_t ArenaBytes, typename Traits = hashmap_policy::DefaultTraits>
+class LockFreeVarLenHashMap : private LockFreeFixedSizeHashMap<details::SlabKey, details::SlabEntry, MaxElems, details::SlabTraits<Traits>>
+{
+	using Base = LockFreeFixedSizeHashMap<details::SlabKey, details::SlabEntry, MaxElems, details::SlabTraits<Traits>>;
+	using Arena = details::SlabArena<ArenaBytes>;
+	using Lookup = details::SlabLookup<Arena>;
+	static_assert(MaxElems != std::dynamic_extent, "Variable length map supports compile time capacity only");
+	static_assert(!Traits::Writers::Concurrent, "Variable length map supports single writer only");
+	static_assert(!Traits::Eviction::Enabled, "Variable length map does not support eviction");
+	static_assert(Traits::Index::Levels == 0, "Variable length map does not support the sorted index");
+
+public:
+	static constexpr size_t MaxLength = Arena::MaxLength;
+
+	using Base::capacity;
+	using Base::stats;
+
+	static constexpr size_t arena_capacity() { return ArenaBytes; }
+	size_t arena_used() const { return arena.used(); }
+
+	//	Same as LockFreeFixedSizeHashMap::shared_memory_size/create_in/attach_to, the arena included
+	static constexpr size_t shared_memory_size()
+	{
+		return Base::template shared_memory_size_of<LockFreeVarLenHashMap>();
+	}
+
+	static LockFreeVarLenHashMap* create_in(void* memory, size_t size)
+	{
+		return Base::template create_as<LockFreeVarLenHashMap>(memory, size);
+	}
+
+	static LockFreeVarLenHashMap* attach_to(void* memory, size_t size)
+	{
+		return Base::template attach_as<LockFreeVarLenHashMap>(memory, size);
+	}
+
+	//	Returns true if the key was inserted, false if its value was overwritten.
+	//	Throws if the map or the arena is full (or either is longer than MaxLength), the map is left as it was then.
+	bool store(std::string_view key, std::string_view value)
+	{
+		const Lookup lookup = lookup_of(key);
+		//	single writer, nobody else changes the node meanwhile
+		const std::optional<uint32_t> key_offset = Base::read_with(lookup, [](const details::SlabEntry& entry) { return entry.key; });
+		const uint32_t value_offset = arena.store(value);
+
+		if (key_offset)
+		{
+			uint32_t old_value_offset = 0;
+			Base::compute(details::SlabKey{ lookup.hash, *key_offset }, [&](const details::SlabEntry* entry) {
+				old_value_offset = entry->value;
+				return std::optional<details::SlabEntry>(details::SlabEntry{ entry->key, value_offset });
+			});
+			//	node version has moved on, readers still viewing the old bytes will retry
+			arena.free(old_value_offset);
+			return false;
+		}
+
+		details::SlabKey node_key{ lookup.hash, 0 };
+		try
+		{
+			node_key.offset = arena.store(key);
+		}
+		catch (...)
+		{
+			arena.free(value_offset);
+			throw;
+		}
+
+		try
+		{
+			Base::store(node_key, details::SlabEntry{ node_key.offset, value_offset });
+		}
+		catch (...)
+		{
+			arena.free(node_key.offset);
+			arena.free(value_offset);
+			throw;
+		}
+		return true;
+	}
+
+	std::optional<std::string> read(std::string_view key)
+	{
+		std::string value;
+		if (!read_with(key, [&](std::string_view bytes) { value.assign(bytes); return true; }))
+			return std::nullopt;
+		return value;
+	}
+
+	//	Copies the value into `buffer` and returns its length. Only the part fitting `buffer` is copied, no allocations.
+	std::optional<size_t> read(std::string_view key, std::span<char> buffer)
+	{
+		return read_with(key, [&](std::string_view bytes) {
+			bytes.copy(buffer.data(), buffer.size());
+			return bytes.size();
+		});
+	}
+
+	//	Reads in place: `project(std::string_view value)` runs on the bytes inside of the arena, its result is returned.
+	//	Same rules as for LockFreeFixedSizeHashMap::read_with projection - the bytes might be torn, result is thrown away then.
+	template<typename F>
+	auto read_with(std::string_view key, F&& project)
+	{
+		return Base::read_with(lookup_of(key), [&](const details::SlabEntry& entry) { return project(arena.view(entry.value)); });
+	}
+
+	bool remove(std::string_view key)
+	{
+		details::SlabEntry removed{};
+		if (!Base::remove_if(lookup_of(key), [&](const details::SlabEntry& entry) { removed = entry; return true; }))
+			return false;
+
+		//	node is unlinked and its version has moved on (or it's retired), readers still viewing the slabs will retry
+		arena.free(removed.key);
+		arena.free(removed.value);
+		return true;
+	}
+
+	template<typename F>	//	func(std::string_view key, std::string_view value), views are valid during the call only
+	void visit(F func)
+	{
+		std::string key, value;
+		Base::visit_with([&](const details::SlabKey& node_key, const details::SlabEntry& entry) {
+				key.assign(arena.view(node_key.offset));
+				value.assign(arena.view(entry.value));
+				return true;
+			},
+			[&](bool) { func(std::string_view(key), std::string_view(value)); });
+	}
+
+private:
+	Lookup lookup_of(std::string_view key) const
+	{
+		return { details::wyhash(key.data(), key.size()), key, &arena };
+	}
+
+	Arena arena;
+};
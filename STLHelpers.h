@@ -1207,7 +1207,7 @@ namespace alg
 
 	//	Function generates key, that does not exist in the map
 	template<typename K, typename V, typename P, typename A>
-	typename K  new_map_id(const std::map<K, V, P, A>& m)
+	K  new_map_id(const std::map<K, V, P, A>& m)
 	{
 		typedef typename std::remove_cv<K>::type  IdxType;
 
@@ -1,11 +1,27 @@
+#include <string>
+#include <string_view>
 
 void LINQTest();
 void lock_free_hash_map_tests();
+void lock_free_hash_map_benchmarks();
 
-int main()
+//	STL-Helpers                  - tests, lock free hash map tests repeated a million times to shake out races
+//	STL-Helpers --iterations N   - same, repeated N times
+//	STL-Helpers --bench          - micro benchmarks
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && std::string_view(argv[1]) == "--bench")
+	{
+		lock_free_hash_map_benchmarks();
+		return 0;
+	}
+
+	int iterations = 1000000;
+	if (argc > 2 && std::string_view(argv[1]) == "--iterations")
+		iterations = std::stoi(argv[2]);
+
 	LINQTest();
-	for(int i = 0; i < 1000000; ++i)
+	for(int i = 0; i < iterations; ++i)
 		lock_free_hash_map_tests();
 
 	return 0;